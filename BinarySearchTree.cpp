@@ -6,26 +6,41 @@
 // Description : Hello World in C++, Ansi-style
 //============================================================================
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
 #include <time.h>
+#include <vector>
 #include "CSVparser.hpp"
 
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
 using namespace std;
 
 //============================================================================
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
+// fund names shared by every bid; a bid only stores its fund's id
+csv::Dictionary funds;
 
 // define a structure to hold bid information
 struct Bid {
     string bidId; // unique identifier
     string title;
-    string fund;
+    csv::Dictionary::Id fundId; // index into funds
     double amount;
     Bid() {
+        fundId = 0;
         amount = 0.0;
     }
 };
@@ -40,12 +55,26 @@ struct Node {
     // Declare child node greater than parent
     struct Node* rightChild;
 
+    // Declare the node this is a child of, nullptr for the root
+    struct Node* parent;
+
+    // Levels in the subtree rooted here; only kept up to date
+    // in a balanced tree
+    int height;
+
+    // Whether the node is part of a block from BulkLoad rather
+    // than allocated on its own
+    bool inBlock;
+
     // Default constructor new for node
     Node() {
 
         // Initialize children nodes
         leftChild = nullptr;
         rightChild = nullptr;
+        parent = nullptr;
+        height = 1;
+        inBlock = false;
     }
 
     // Call default constructor and assign bid to node
@@ -55,278 +84,1312 @@ struct Node {
 };
 
 
+//============================================================================
+// Bid Index interface
+//============================================================================
+
+/**
+ * Define the operations the tool needs from a container of bids
+ * ordered by bid ID, so a BinarySearchTree or a BPlusTree can
+ * hold them
+ */
+class BidIndex {
+
+public:
+    virtual ~BidIndex() {
+    }
+    virtual void InOrder() = 0;
+    virtual void Insert(Bid bid) = 0;
+    virtual void Remove(string bidId) = 0;
+    virtual Bid Search(string bidId) = 0;
+    virtual void RangeScan(string lo, string hi, function<void(const Bid&)> visit) = 0;
+    virtual unsigned int Size() = 0;
+    virtual unsigned int Height() = 0;
+};
+
+
 //============================================================================
 // Binary Search Tree class definition
 //============================================================================
 
+// how a BinarySearchTree keeps its shape
+enum Balancing {
+    eNONE = 0, // nodes stay where they were inserted
+    eAVL = 1   // subtree heights differ by at most one
+};
+
 /**
  * Define a class containing data members and methods to
- * implement a binary search tree
+ * implement a binary search tree.
+ *
+ * In eAVL mode every insert and remove walks back up to the
+ * root and rotates wherever a node's subtrees differ in height
+ * by more than one, so the tree stays O(log n) deep even when
+ * the bids arrive sorted, as they do in the eBid exports. In
+ * eNONE mode sorted input makes the tree a linked list. Nothing
+ * recurses on the tree's depth, so neither mode can run out of
+ * stack.
+ *
+ * Bids can also be walked in order, either way, from any point
+ * with an iterator; stepping follows child and parent links, so
+ * a walk over k bids after a lower_bound costs O(log n + k).
+ *
+ * BulkLoad builds a perfectly balanced tree from a whole set of
+ * bids at once in O(n), with the nodes in one block in bid ID
+ * order, so in-order walks read memory front to back.
  */
-class BinarySearchTree {
+class BinarySearchTree : public BidIndex {
+
+public:
+    /**
+     * A bidirectional iterator over the bids in bid ID order.
+     * Bids can't be changed through it, since that could move
+     * them out of order. It stays valid until its own bid is
+     * removed.
+     */
+    class iterator {
+
+    private:
+        friend class BinarySearchTree;
+
+        Node* node; // nullptr at end()
+        const BinarySearchTree* tree;
+
+        iterator(Node* node, const BinarySearchTree* tree) : node(node), tree(tree) {
+        }
+
+    public:
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef Bid value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Bid* pointer;
+        typedef const Bid& reference;
+
+        iterator() : node(nullptr), tree(nullptr) {
+        }
+
+        reference operator*() const {
+            return node->bid;
+        }
+
+        pointer operator->() const {
+            return &node->bid;
+        }
+
+        iterator& operator++() {
+            node = successor(node);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator before = *this;
+            ++*this;
+            return before;
+        }
+
+        // stepping back from end() reaches the last bid
+        iterator& operator--() {
+            node = node != nullptr ? predecessor(node) : rightmost(tree->root);
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator before = *this;
+            --*this;
+            return before;
+        }
+
+        bool operator==(const iterator& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return node != other.node;
+        }
+    };
 
 private:
     Node* root;
-
-    void addNode(Node* node, Bid bid);
-    void inOrder(Node* node);
-    Node* removeNode(Node* node, string bidId);
-    void preOrder(Node* node);
-    void postOrder(Node* node);
+    Balancing balancing;
+    unsigned int size;
+
+    // node blocks from BulkLoad; their nodes are never deleted
+    // one by one
+    vector<unique_ptr<Node[]> > blocks;
+
+    static int height(Node* node);
+    static void updateHeight(Node* node);
+    static Node* leftmost(Node* node);
+    static Node* rightmost(Node* node);
+    static Node* successor(Node* node);
+    static Node* predecessor(Node* node);
+    void replaceChild(Node* parent, Node* child, Node* replacement);
+    Node* rotateLeft(Node* node);
+    Node* rotateRight(Node* node);
+    void rebalance(Node* node);
+    Node* findNode(string bidId);
+    void removeNode(Node* node);
+    void clear();
+    Node* link(Node* first, Node* last, Node* parent);
 
 public:
-    BinarySearchTree();
+    BinarySearchTree(Balancing balancing = eAVL);
     virtual ~BinarySearchTree();
-    void InOrder();
+    void InOrder() override;
     void PreOrder();
     void PostOrder();
-    void Insert(Bid bid);
-    void Remove(string bidId);
-    Bid Search(string bidId);
+    void Insert(Bid bid) override;
+    void BulkLoad(vector<Bid> bids);
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void RangeScan(string lo, string hi, function<void(const Bid&)> visit) override;
+    unsigned int Size() override;
+    unsigned int Height() override;
+
+    iterator begin() const;
+    iterator end() const;
+    iterator lower_bound(const string& bidId) const;
+    iterator upper_bound(const string& bidId) const;
 };
 
 /**
  * Default constructor
+ *
+ * @param balancing How the tree keeps its shape
  */
-BinarySearchTree::BinarySearchTree() {
+BinarySearchTree::BinarySearchTree(Balancing balancing) {
 
     // Set root equal to nullptr
     root = nullptr;
+    this->balancing = balancing;
+    size = 0;
+}
+
+/**
+ * Destructor
+ */
+BinarySearchTree::~BinarySearchTree() {
+    clear();
+}
+
+/**
+ * Delete every node, leaving the tree empty
+ */
+void BinarySearchTree::clear() {
+
+    // Delete leaves, climbing back up to each parent once its
+    // children are gone
+    Node* node = root;
+    while (node != nullptr) {
+        if (node->leftChild != nullptr) {
+            node = node->leftChild;
+        }
+        else if (node->rightChild != nullptr) {
+            node = node->rightChild;
+        }
+        else {
+            Node* parent = node->parent;
+            if (parent != nullptr) {
+                if (parent->leftChild == node) {
+                    parent->leftChild = nullptr;
+                }
+                else {
+                    parent->rightChild = nullptr;
+                }
+            }
+            if (!node->inBlock) {
+                delete node;
+            }
+            node = parent;
+        }
+    }
+
+    root = nullptr;
+    size = 0;
+    blocks.clear();
+}
+
+/**
+ * Traverse the tree in order
+ */
+void BinarySearchTree::InOrder() {
+
+    // Step from the smallest bid to each next larger one
+    for (Node* node = leftmost(root); node != nullptr; node = successor(node)) {
+
+        // Output bid ID, title, amount, and fund
+        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
+            << funds.lookup(node->bid.fundId) << endl;
+    }
+}
+
+/**
+ * Traverse the tree in post-order, following parent links
+ * instead of recursing
+ */
+void BinarySearchTree::PostOrder() {
+
+    // Start at the first leaf reached keeping left where possible
+    Node* node = root;
+    while (node != nullptr && (node->leftChild != nullptr || node->rightChild != nullptr)) {
+        node = node->leftChild != nullptr ? node->leftChild : node->rightChild;
+    }
+
+    while (node != nullptr) {
+
+        // Output bid ID, title, amount, and fund
+        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
+            << funds.lookup(node->bid.fundId) << endl;
+
+        // A left child is followed by its parent's right subtree,
+        // if any, starting at that subtree's first leaf; anything
+        // else by its parent
+        Node* parent = node->parent;
+        if (parent != nullptr && parent->leftChild == node && parent->rightChild != nullptr) {
+            node = parent->rightChild;
+            while (node->leftChild != nullptr || node->rightChild != nullptr) {
+                node = node->leftChild != nullptr ? node->leftChild : node->rightChild;
+            }
+        }
+        else {
+            node = parent;
+        }
+    }
+}
+
+/**
+ * Traverse the tree in pre-order, following parent links
+ * instead of recursing
+ */
+void BinarySearchTree::PreOrder() {
+    Node* node = root;
+    while (node != nullptr) {
+
+        // Output bid ID, title, amount, and fund
+        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
+            << funds.lookup(node->bid.fundId) << endl;
+
+        // Go down if possible; otherwise climb to the nearest
+        // ancestor with a right subtree not yet visited
+        if (node->leftChild != nullptr) {
+            node = node->leftChild;
+        }
+        else if (node->rightChild != nullptr) {
+            node = node->rightChild;
+        }
+        else {
+            while (node->parent != nullptr
+                && (node->parent->rightChild == node || node->parent->rightChild == nullptr)) {
+                node = node->parent;
+            }
+            node = node->parent != nullptr ? node->parent->rightChild : nullptr;
+        }
+    }
+}
+
+/**
+ * Insert a bid. A bid whose ID is already in the tree goes
+ * after the ones there.
+ */
+void BinarySearchTree::Insert(Bid bid) {
+    Node* parent = nullptr;
+    Node** link = &root;
+
+    // Walk down to the empty child the bid belongs in, left if
+    // the node's bid ID is larger and right otherwise
+    while (*link != nullptr) {
+        parent = *link;
+        if (parent->bid.bidId.compare(bid.bidId) > 0) {
+            link = &parent->leftChild;
+        }
+        else {
+            link = &parent->rightChild;
+        }
+    }
+
+    *link = new Node(bid);
+    (*link)->parent = parent;
+    size++;
+
+    if (balancing == eAVL) {
+        rebalance(parent);
+    }
+}
+
+/**
+ * Replace the tree with a perfectly balanced one holding its
+ * bids and these, in O(n) past sorting. Bids already sorted by
+ * ID, as the eBid exports are, aren't sorted again. Bids whose
+ * IDs are already in the tree go after the ones there, as they
+ * would with Insert. Insert and Remove work on the result as on
+ * any other tree.
+ *
+ * @param bids The bids to add
+ */
+void BinarySearchTree::BulkLoad(vector<Bid> bids) {
+    auto byId = [](const Bid& a, const Bid& b) {
+        return a.bidId.compare(b.bidId) < 0;
+    };
+    if (!is_sorted(bids.begin(), bids.end(), byId)) {
+        stable_sort(bids.begin(), bids.end(), byId);
+    }
+
+    // Merge in the bids already here, which come out sorted
+    if (root != nullptr) {
+        vector<Bid> merged;
+        merged.reserve(size + bids.size());
+        merge(begin(), end(), bids.begin(), bids.end(), back_inserter(merged), byId);
+        bids.swap(merged);
+    }
+
+    // Start over; this also frees the blocks of earlier loads whose
+    // bids have all been removed
+    clear();
+    if (bids.empty()) {
+        return;
+    }
+
+    // Node i of the block holds the i-th bid in order
+    Node* block = new Node[bids.size()];
+    blocks.push_back(unique_ptr<Node[]>(block));
+    for (unsigned int i = 0; i < bids.size(); i++) {
+        block[i].bid = move(bids[i]);
+        block[i].inBlock = true;
+    }
+
+    root = link(block, block + bids.size(), nullptr);
+    size = bids.size();
+}
+
+/**
+ * Link a run of nodes, in bid ID order, into a perfectly
+ * balanced subtree rooted at its middle node. Recurses once per
+ * level, and the levels are only O(log n).
+ *
+ * @param first The first node of the run
+ * @param last Past the last node of the run
+ * @param parent The node the subtree hangs from
+ * @return The subtree's root, or nullptr for an empty run
+ */
+Node* BinarySearchTree::link(Node* first, Node* last, Node* parent) {
+    if (first == last) {
+        return nullptr;
+    }
+
+    Node* middle = first + (last - first) / 2;
+    middle->parent = parent;
+    middle->leftChild = link(first, middle, middle);
+    middle->rightChild = link(middle + 1, last, middle);
+    updateHeight(middle);
+    return middle;
+}
+
+/**
+ * Remove a bid
+ */
+void BinarySearchTree::Remove(string bidId) {
+    Node* node = findNode(bidId);
+    if (node != nullptr) {
+        removeNode(node);
+    }
+}
+
+/**
+ * Search for a bid
+ */
+Bid BinarySearchTree::Search(string bidId) {
+    Node* node = findNode(bidId);
+    if (node != nullptr) {
+        return node->bid;
+    }
+
+    // Return empty bid if no matching bid found
+    return Bid();
+}
+
+/**
+ * Visit every bid with an ID from lo to hi, both included, in
+ * order. Only the path down to lo and the bids in the range are
+ * touched.
+ *
+ * @param lo The smallest bid ID to visit
+ * @param hi The largest bid ID to visit
+ * @param visit The function to call with each bid
+ */
+void BinarySearchTree::RangeScan(string lo, string hi, function<void(const Bid&)> visit) {
+    for (iterator it = lower_bound(lo); it != end() && it->bidId.compare(hi) <= 0; ++it) {
+        visit(*it);
+    }
+}
+
+/**
+ * Iterator at the bid with the smallest ID
+ */
+BinarySearchTree::iterator BinarySearchTree::begin() const {
+    return iterator(leftmost(root), this);
+}
+
+/**
+ * Iterator past the bid with the largest ID
+ */
+BinarySearchTree::iterator BinarySearchTree::end() const {
+    return iterator(nullptr, this);
+}
+
+/**
+ * Iterator at the first bid whose ID is not less than bidId,
+ * or end()
+ */
+BinarySearchTree::iterator BinarySearchTree::lower_bound(const string& bidId) const {
+    Node* found = nullptr;
+    Node* node = root;
+
+    // Every node at or above bidId is a candidate; the last one
+    // seen on the way down is the smallest
+    while (node != nullptr) {
+        if (node->bid.bidId.compare(bidId) >= 0) {
+            found = node;
+            node = node->leftChild;
+        }
+        else {
+            node = node->rightChild;
+        }
+    }
+    return iterator(found, this);
+}
+
+/**
+ * Iterator at the first bid whose ID is greater than bidId,
+ * or end()
+ */
+BinarySearchTree::iterator BinarySearchTree::upper_bound(const string& bidId) const {
+    Node* found = nullptr;
+    Node* node = root;
+
+    while (node != nullptr) {
+        if (node->bid.bidId.compare(bidId) > 0) {
+            found = node;
+            node = node->leftChild;
+        }
+        else {
+            node = node->rightChild;
+        }
+    }
+    return iterator(found, this);
+}
+
+/**
+ * Number of bids in the tree
+ */
+unsigned int BinarySearchTree::Size() {
+    return size;
+}
+
+/**
+ * Number of levels in the tree, found by visiting every node
+ * so it is right in either mode
+ */
+unsigned int BinarySearchTree::Height() {
+    unsigned int levels = 0;
+    vector<pair<Node*, unsigned int> > pending;
+    if (root != nullptr) {
+        pending.push_back(make_pair(root, 1u));
+    }
+
+    while (!pending.empty()) {
+        Node* node = pending.back().first;
+        unsigned int depth = pending.back().second;
+        pending.pop_back();
+        levels = max(levels, depth);
+        if (node->leftChild != nullptr) {
+            pending.push_back(make_pair(node->leftChild, depth + 1));
+        }
+        if (node->rightChild != nullptr) {
+            pending.push_back(make_pair(node->rightChild, depth + 1));
+        }
+    }
+    return levels;
+}
+
+/**
+ * Height of a subtree; 0 for an empty one
+ */
+int BinarySearchTree::height(Node* node) {
+    return node != nullptr ? node->height : 0;
+}
+
+/**
+ * Recompute a node's height from its children's
+ */
+void BinarySearchTree::updateHeight(Node* node) {
+    node->height = 1 + max(height(node->leftChild), height(node->rightChild));
+}
+
+/**
+ * The node with the smallest bid ID in a subtree, or nullptr
+ */
+Node* BinarySearchTree::leftmost(Node* node) {
+    if (node != nullptr) {
+        while (node->leftChild != nullptr) {
+            node = node->leftChild;
+        }
+    }
+    return node;
+}
+
+/**
+ * The node with the largest bid ID in a subtree, or nullptr
+ */
+Node* BinarySearchTree::rightmost(Node* node) {
+    if (node != nullptr) {
+        while (node->rightChild != nullptr) {
+            node = node->rightChild;
+        }
+    }
+    return node;
+}
+
+/**
+ * The node after a node in order, or nullptr after the last
+ */
+Node* BinarySearchTree::successor(Node* node) {
+
+    // The next node is the smallest one on the right, if any
+    if (node->rightChild != nullptr) {
+        return leftmost(node->rightChild);
+    }
+
+    // Otherwise climb until coming up out of a left subtree
+    while (node->parent != nullptr && node->parent->rightChild == node) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/**
+ * The node before a node in order, or nullptr before the first
+ */
+Node* BinarySearchTree::predecessor(Node* node) {
+
+    // The previous node is the largest one on the left, if any
+    if (node->leftChild != nullptr) {
+        return rightmost(node->leftChild);
+    }
+
+    // Otherwise climb until coming up out of a right subtree
+    while (node->parent != nullptr && node->parent->leftChild == node) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/**
+ * Put replacement where child hangs off parent, or make it the
+ * root if child was the root
+ *
+ * @param parent The parent of child, or nullptr
+ * @param child The node being replaced
+ * @param replacement The node taking its place, or nullptr
+ */
+void BinarySearchTree::replaceChild(Node* parent, Node* child, Node* replacement) {
+    if (parent == nullptr) {
+        root = replacement;
+    }
+    else if (parent->leftChild == child) {
+        parent->leftChild = replacement;
+    }
+    else {
+        parent->rightChild = replacement;
+    }
+
+    if (replacement != nullptr) {
+        replacement->parent = parent;
+    }
+}
+
+/**
+ * Lift a node's right child into its place
+ *
+ * @param node The root of the subtree to rotate
+ * @return The subtree's new root
+ */
+Node* BinarySearchTree::rotateLeft(Node* node) {
+    Node* pivot = node->rightChild;
+
+    node->rightChild = pivot->leftChild;
+    if (pivot->leftChild != nullptr) {
+        pivot->leftChild->parent = node;
+    }
+    replaceChild(node->parent, node, pivot);
+    pivot->leftChild = node;
+    node->parent = pivot;
+
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+/**
+ * Lift a node's left child into its place
+ *
+ * @param node The root of the subtree to rotate
+ * @return The subtree's new root
+ */
+Node* BinarySearchTree::rotateRight(Node* node) {
+    Node* pivot = node->leftChild;
+
+    node->leftChild = pivot->rightChild;
+    if (pivot->rightChild != nullptr) {
+        pivot->rightChild->parent = node;
+    }
+    replaceChild(node->parent, node, pivot);
+    pivot->rightChild = node;
+    node->parent = pivot;
+
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+/**
+ * Restore the AVL balance from a changed node up to the root
+ *
+ * @param node The lowest node whose subtree changed
+ */
+void BinarySearchTree::rebalance(Node* node) {
+    while (node != nullptr) {
+        updateHeight(node);
+        int balance = height(node->leftChild) - height(node->rightChild);
+
+        // Left heavy; a right leaning left child is rotated first
+        if (balance > 1) {
+            if (height(node->leftChild->leftChild) < height(node->leftChild->rightChild)) {
+                rotateLeft(node->leftChild);
+            }
+            node = rotateRight(node);
+        }
+
+        // Right heavy; a left leaning right child is rotated first
+        else if (balance < -1) {
+            if (height(node->rightChild->rightChild) < height(node->rightChild->leftChild)) {
+                rotateRight(node->rightChild);
+            }
+            node = rotateLeft(node);
+        }
+
+        node = node->parent;
+    }
+}
+
+/**
+ * Find the first node holding a bid ID
+ *
+ * @param bidId The bid ID to search for
+ * @return The node, or nullptr
+ */
+Node* BinarySearchTree::findNode(string bidId) {
+
+    // Descend as lower_bound does, so of several copies the first
+    // in order is found, as BPlusTree finds it
+    iterator found = lower_bound(bidId);
+    if (found == end() || found->bidId != bidId) {
+        return nullptr;
+    }
+    return found.node;
+}
+
+/**
+ * Unlink a node from the tree and delete it. A node with two
+ * children is replaced by its successor, moved rather than
+ * copied, so no other node's bid changes place.
+ *
+ * @param node The node to remove
+ */
+void BinarySearchTree::removeNode(Node* node) {
+
+    // The lowest node whose subtree loses a level
+    Node* changed;
+
+    // If node has at most one child, that child takes its place
+    if (node->leftChild == nullptr || node->rightChild == nullptr) {
+        Node* child = node->leftChild != nullptr ? node->leftChild : node->rightChild;
+        changed = node->parent;
+        replaceChild(node->parent, node, child);
+    }
+
+    // If node has two children, the leftmost child of its right
+    // subtree takes its place
+    else {
+        Node* next = leftmost(node->rightChild);
+        if (next->parent != node) {
+            changed = next->parent;
+            replaceChild(next->parent, next, next->rightChild);
+            next->rightChild = node->rightChild;
+            next->rightChild->parent = next;
+        }
+        else {
+            changed = next;
+        }
+        next->leftChild = node->leftChild;
+        next->leftChild->parent = next;
+        replaceChild(node->parent, node, next);
+    }
+
+    // A node in a block stays allocated until the tree goes, but
+    // its bid is released now
+    if (node->inBlock) {
+        node->bid = Bid();
+    }
+    else {
+        delete node;
+    }
+    size--;
+
+    if (balancing == eAVL) {
+        rebalance(changed);
+    }
+}
+
+
+//============================================================================
+// B+ Tree class definition
+//============================================================================
+
+// keys per B+ tree node; a node's high key words fill two cache lines
+const unsigned int INNER_KEYS = 16;
+const unsigned int LEAF_KEYS = 16;
+
+// key value of an unused slot, above every real key
+const uint64_t NO_KEY = ~0ULL;
+
+// Internal structures for B+ tree nodes. A bid ID is packed into
+// two words, first byte highest, so comparing (hi, lo) as numbers
+// orders IDs as strings; hi and lo are kept in separate arrays so
+// a node search reads only keys.
+struct BPlusNode {
+    uint64_t hi[INNER_KEYS];
+    uint64_t lo[INNER_KEYS];
+    unsigned int count; // keys in use
+
+    BPlusNode() {
+        fill(hi, hi + INNER_KEYS, NO_KEY);
+        fill(lo, lo + INNER_KEYS, NO_KEY);
+        count = 0;
+    }
+};
+
+// children[i] holds keys from separator i - 1 up to separator i
+struct alignas(64) BPlusInner : BPlusNode {
+    BPlusNode* children[INNER_KEYS + 1];
+};
+
+// leaves are linked both ways in key order
+struct alignas(64) BPlusLeaf : BPlusNode {
+    BPlusLeaf* previous = nullptr;
+    BPlusLeaf* next = nullptr;
+    Bid bids[LEAF_KEYS];
+};
+
+static_assert(INNER_KEYS == LEAF_KEYS, "leaves and inner nodes share one key layout");
+
+/**
+ * Ask for the cache line holding p ahead of its use
+ */
+inline void prefetch(const void* p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#endif
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement a B+ tree of bids keyed by bid ID.
+ *
+ * Inner nodes hold only keys and child pointers, INNER_KEYS to a
+ * node, so a lookup touches a few cache lines per level over a
+ * tree a handful of levels deep, where a binary tree takes a
+ * cache miss per level over twenty or more. A node is searched
+ * by counting the keys below the target across every slot,
+ * unused ones included, which compiles to a fixed run of
+ * compares without branches, while a search's child pointers
+ * are prefetched. The bids themselves sit in the leaves, which
+ * are linked in order for scans.
+ *
+ * A key holds the first 16 bytes of a bid ID. Bids whose IDs
+ * share a key, copies or longer IDs with the same start, are
+ * kept in order of their full IDs, and a run of them is walked
+ * bid by bid. Remove frees nodes that empty but doesn't merge
+ * nodes that are merely underfull, so the tree stays as deep as
+ * it has ever been.
+ */
+class BPlusTree : public BidIndex {
+
+private:
+    BPlusNode* root;
+    unsigned int height; // levels, 1 when the root is a leaf
+    unsigned int size;
+
+    // inner nodes on the way to the last leaf reached, and the
+    // child taken from each
+    vector<pair<BPlusInner*, unsigned int> > path;
+
+    static void packKey(const string& bidId, uint64_t& hi, uint64_t& lo);
+    static unsigned int lowerBound(const BPlusNode* node, uint64_t hi, uint64_t lo);
+    static void insertKey(BPlusNode* node, unsigned int slot, uint64_t hi, uint64_t lo);
+    static void removeKey(BPlusNode* node, unsigned int slot);
+    BPlusLeaf* leftmostLeaf();
+    BPlusLeaf* findLeaf(uint64_t hi, uint64_t lo);
+    void nextLeaf();
+    BPlusLeaf* seek(const string& bidId, bool after, unsigned int& slot);
+    void insertChild(uint64_t hi, uint64_t lo, BPlusNode* child, bool append);
+    void removeLeaf(BPlusLeaf* leaf);
+    void destroy(BPlusNode* node, unsigned int level);
+
+public:
+    BPlusTree();
+    virtual ~BPlusTree();
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+    void InOrder() override;
+    void Insert(Bid bid) override;
+    void Remove(string bidId) override;
+    Bid Search(string bidId) override;
+    void RangeScan(string lo, string hi, function<void(const Bid&)> visit) override;
+    unsigned int Size() override;
+    unsigned int Height() override;
+};
+
+/**
+ * Default constructor
+ */
+BPlusTree::BPlusTree() {
+    root = new BPlusLeaf();
+    height = 1;
+    size = 0;
+}
+
+/**
+ * Destructor
+ */
+BPlusTree::~BPlusTree() {
+    destroy(root, 1);
+}
+
+/**
+ * Delete a subtree; recurses once per level, not per node
+ *
+ * @param node The subtree's root
+ * @param level The node's level, 1 for the root
+ */
+void BPlusTree::destroy(BPlusNode* node, unsigned int level) {
+    if (level == height) {
+        delete static_cast<BPlusLeaf*>(node);
+        return;
+    }
+
+    BPlusInner* inner = static_cast<BPlusInner*>(node);
+    for (unsigned int i = 0; i <= inner->count; i++) {
+        destroy(inner->children[i], level + 1);
+    }
+    delete inner;
+}
+
+/**
+ * Pack a bid ID into a key. An ID longer than 16 bytes gets
+ * the key of its first 16, which sorts no later than it.
+ */
+void BPlusTree::packKey(const string& bidId, uint64_t& hi, uint64_t& lo) {
+    hi = lo = 0;
+    for (unsigned int i = 0; i < bidId.size() && i < 16; i++) {
+        uint64_t byte = (unsigned char) bidId[i];
+        if (i < 8) {
+            hi |= byte << (56 - 8 * i);
+        }
+        else {
+            lo |= byte << (120 - 8 * i);
+        }
+    }
 }
 
 /**
- * Destructor
+ * Number of keys in a node below a key. The high words are
+ * counted without branches; low words are only read past keys
+ * whose high word ties, which IDs of 8 bytes or less never need.
  */
-BinarySearchTree::~BinarySearchTree() {
-    // recurse from root deleting every node
+unsigned int BPlusTree::lowerBound(const BPlusNode* node, uint64_t hi, uint64_t lo) {
+    unsigned int below = 0;
+    for (unsigned int i = 0; i < INNER_KEYS; i++) {
+        below += node->hi[i] < hi;
+    }
+    while (below < INNER_KEYS && node->hi[below] == hi && node->lo[below] < lo) {
+        below++;
+    }
+    return below;
 }
 
 /**
- * Traverse the tree in order
+ * Open a key slot in a node that has room
  */
-void BinarySearchTree::InOrder() {
-
-    // Call inOrder fuction and pass root 
-    this->inOrder(root);
+void BPlusTree::insertKey(BPlusNode* node, unsigned int slot, uint64_t hi, uint64_t lo) {
+    copy_backward(node->hi + slot, node->hi + node->count, node->hi + node->count + 1);
+    copy_backward(node->lo + slot, node->lo + node->count, node->lo + node->count + 1);
+    node->hi[slot] = hi;
+    node->lo[slot] = lo;
+    node->count++;
 }
 
 /**
- * Traverse the tree in post-order
+ * Close a key slot, leaving the freed one at the end unused
  */
-void BinarySearchTree::PostOrder() {
-    
-    // Call postOrder fuction and pass root 
-    this->postOrder(root);
+void BPlusTree::removeKey(BPlusNode* node, unsigned int slot) {
+    copy(node->hi + slot + 1, node->hi + node->count, node->hi + slot);
+    copy(node->lo + slot + 1, node->lo + node->count, node->lo + slot);
+    node->count--;
+    node->hi[node->count] = NO_KEY;
+    node->lo[node->count] = NO_KEY;
 }
 
 /**
- * Traverse the tree in pre-order
+ * The first leaf in key order
  */
-void BinarySearchTree::PreOrder() {
-    
-    // Call preOrder fuction and pass root 
-    this->preOrder(root);
+BPlusLeaf* BPlusTree::leftmostLeaf() {
+    BPlusNode* node = root;
+    for (unsigned int level = 1; level < height; level++) {
+        node = static_cast<BPlusInner*>(node)->children[0];
+    }
+    return static_cast<BPlusLeaf*>(node);
 }
 
 /**
- * Insert a bid
+ * Walk down to the leaf holding the first bid with a key no
+ * lower than a key, or the leaf before it, recording the path
  */
-void BinarySearchTree::Insert(Bid bid) {
-
-    // If root is empty, assign root to new bid
-    if (root == nullptr) {
-        root = new Node(bid);
-    }
-
-    // Call addNode, passing root and bid as parameters
-    else {
-        this->addNode(root, bid);
+BPlusLeaf* BPlusTree::findLeaf(uint64_t hi, uint64_t lo) {
+    BPlusNode* node = root;
+    path.clear();
+    for (unsigned int level = 1; level < height; level++) {
+        BPlusInner* inner = static_cast<BPlusInner*>(node);
+
+        // The child pointers load while the keys are compared
+        for (unsigned int i = 0; i <= INNER_KEYS; i += 8) {
+            prefetch(&inner->children[i]);
+        }
+        unsigned int slot = lowerBound(inner, hi, lo);
+        path.push_back(make_pair(inner, slot));
+        node = inner->children[slot];
     }
+    return static_cast<BPlusLeaf*>(node);
 }
 
 /**
- * Remove a bid
+ * Move the recorded path on to the next leaf, which must exist
  */
-void BinarySearchTree::Remove(string bidId) {
-    
-    // Call removeNode, passing root and bid as parameters
-    this->removeNode(root, bidId);
+void BPlusTree::nextLeaf() {
+    unsigned int level = path.size();
+    while (path[level - 1].second == path[level - 1].first->count) {
+        level--;
+    }
+    path[level - 1].second++;
+
+    for (; level < path.size(); level++) {
+        BPlusInner* parent = path[level - 1].first;
+        path[level] = make_pair(static_cast<BPlusInner*>(parent->children[path[level - 1].second]), 0u);
+    }
 }
 
 /**
- * Search for a bid
+ * Find the place of a bid ID among the bids, recording the path.
+ * The walk starts at the first bid sharing the ID's key and steps
+ * past those whose full IDs sort before it, into later leaves if
+ * the run of them goes on there.
+ *
+ * @param after Whether to step past bids with the same ID too, as
+ *              an insert does, or stop at the first of them
+ * @param slot Set to the place in the leaf returned, which may be
+ *             one past its last bid
  */
-Bid BinarySearchTree::Search(string bidId) {
-    Bid bid;
-
-    // Set current node equal to root
-    Node* currentNode = root;
-    
-    // While currentnode is not equal to nullptr
-    while (currentNode != nullptr) {
-
-        // If bid matches current node bid, return bid
-        if (currentNode->bid.bidId.compare(bidId) == 0) {
-            return currentNode->bid; 
+BPlusLeaf* BPlusTree::seek(const string& bidId, bool after, unsigned int& slot) {
+    uint64_t hi, lo;
+    packKey(bidId, hi, lo);
+
+    BPlusLeaf* leaf = findLeaf(hi, lo);
+    slot = lowerBound(leaf, hi, lo);
+    for (;;) {
+        if (slot == leaf->count) {
+            if (leaf->next == nullptr || leaf->next->hi[0] != hi || leaf->next->lo[0] != lo) {
+                break;
+            }
+            int order = leaf->next->bids[0].bidId.compare(bidId);
+            if (order > 0 || (order == 0 && !after)) {
+                break;
+            }
+            leaf = leaf->next;
+            slot = 0;
+            nextLeaf();
         }
-
-        // If bid is smaller than current node then set current node to left child
-        if (bidId.compare(currentNode->bid.bidId) < 0) {
-            currentNode = currentNode->leftChild;
+        else if (leaf->hi[slot] != hi || leaf->lo[slot] != lo) {
+            break;
         }
-
-        // If bid is bigger than current node then set current node to left child
         else {
-            currentNode = currentNode->rightChild;
+            int order = leaf->bids[slot].bidId.compare(bidId);
+            if (order > 0 || (order == 0 && !after)) {
+                break;
+            }
+            slot++;
         }
     }
-
-    // Return empty bid if no matching bid found
-    return bid;
+    return leaf;
 }
 
 /**
- * Add a bid to some node (recursive)
- *
- * @param node Current node in tree
- * @param bid Bid to be added
+ * Insert a bid. A bid whose ID is already in the tree goes
+ * after the ones there.
  */
-void BinarySearchTree::addNode(Node* node, Bid bid) {
-    
-    // If node bid ID is larger than new node bid ID
-    if (node->bid.bidId.compare(bid.bidId) > 0) {
-
-        // If left child is empty, set new node to left child
-        if (node->leftChild == nullptr) {
-            node->leftChild = new Node(bid);
-        }
-
-        // Else set node to left child and to recurse down tree
-        else {
-            this->addNode(node->leftChild, bid);
-        }
+void BPlusTree::Insert(Bid bid) {
+    uint64_t hi, lo;
+    packKey(bid.bidId, hi, lo);
+
+    unsigned int slot;
+    BPlusLeaf* leaf = seek(bid.bidId, true, slot);
+    size++;
+
+    if (leaf->count < LEAF_KEYS) {
+        move_backward(leaf->bids + slot, leaf->bids + leaf->count, leaf->bids + leaf->count + 1);
+        leaf->bids[slot] = move(bid);
+        insertKey(leaf, slot, hi, lo);
+        return;
     }
 
-    else {
-
-        // If right child is empty, set new node to right child
-        if (node->rightChild == nullptr) {
-            node->rightChild = new Node(bid);
-        }
+    // Split a full leaf. Sorted input only ever appends to the last
+    // leaf, so that split leaves it full and starts a new one.
+    BPlusLeaf* right = new BPlusLeaf();
+    bool append = slot == LEAF_KEYS && leaf->next == nullptr;
+    unsigned int keep = append ? LEAF_KEYS : LEAF_KEYS / 2;
+    for (unsigned int i = keep; i < LEAF_KEYS; i++) {
+        right->bids[i - keep] = move(leaf->bids[i]);
+        right->hi[i - keep] = leaf->hi[i];
+        right->lo[i - keep] = leaf->lo[i];
+        leaf->hi[i] = leaf->lo[i] = NO_KEY;
+    }
+    right->count = LEAF_KEYS - keep;
+    leaf->count = keep;
 
-        // Else set node to right child and to recurse down tree
-        else {
-            this->addNode(node->rightChild, bid);
-        }
+    right->previous = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr) {
+        leaf->next->previous = right;
     }
-}
-void BinarySearchTree::inOrder(Node* node) {
+    leaf->next = right;
 
-    // If node is not equal to null ptr
-    if (node != nullptr) {
+    BPlusLeaf* target = slot <= keep && !append ? leaf : right;
+    slot = target == leaf ? slot : slot - keep;
+    move_backward(target->bids + slot, target->bids + target->count, target->bids + target->count + 1);
+    target->bids[slot] = move(bid);
+    insertKey(target, slot, hi, lo);
 
-        // Traverse left side 
-        inOrder(node->leftChild);
+    insertChild(right->hi[0], right->lo[0], right, append);
+}
 
-        // Output bid ID, title, amount, and fund
-        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
-            << node->bid.fund << endl;
+/**
+ * Hang a new node to the right of the node the path leads to,
+ * splitting inner nodes up the path as they fill
+ *
+ * @param hi, lo The first key under the new node
+ * @param child The new node
+ * @param append Whether the split was at the right edge of the
+ *               tree, so the left node can be kept full
+ */
+void BPlusTree::insertChild(uint64_t hi, uint64_t lo, BPlusNode* child, bool append) {
+    while (!path.empty()) {
+        BPlusInner* inner = path.back().first;
+        unsigned int slot = path.back().second;
+        path.pop_back();
+
+        if (inner->count < INNER_KEYS) {
+            copy_backward(inner->children + slot + 1, inner->children + inner->count + 1,
+                inner->children + inner->count + 2);
+            inner->children[slot + 1] = child;
+            insertKey(inner, slot, hi, lo);
+            return;
+        }
 
-        // Traverse right side 
-        inOrder(node->rightChild);
+        // Line up the keys and children with the new ones in place
+        uint64_t his[INNER_KEYS + 1], los[INNER_KEYS + 1];
+        BPlusNode* children[INNER_KEYS + 2];
+        copy(inner->hi, inner->hi + slot, his);
+        copy(inner->lo, inner->lo + slot, los);
+        his[slot] = hi;
+        los[slot] = lo;
+        copy(inner->hi + slot, inner->hi + INNER_KEYS, his + slot + 1);
+        copy(inner->lo + slot, inner->lo + INNER_KEYS, los + slot + 1);
+        copy(inner->children, inner->children + slot + 1, children);
+        children[slot + 1] = child;
+        copy(inner->children + slot + 1, inner->children + INNER_KEYS + 1, children + slot + 2);
+
+        // The middle key moves up; the right edge keeps the left full
+        append = append && slot == INNER_KEYS;
+        unsigned int middle = append ? INNER_KEYS : INNER_KEYS / 2;
+        BPlusInner* right = new BPlusInner();
+        fill(inner->hi, inner->hi + INNER_KEYS, NO_KEY);
+        fill(inner->lo, inner->lo + INNER_KEYS, NO_KEY);
+        copy(his, his + middle, inner->hi);
+        copy(los, los + middle, inner->lo);
+        copy(children, children + middle + 1, inner->children);
+        inner->count = middle;
+        copy(his + middle + 1, his + INNER_KEYS + 1, right->hi);
+        copy(los + middle + 1, los + INNER_KEYS + 1, right->lo);
+        copy(children + middle + 1, children + INNER_KEYS + 2, right->children);
+        right->count = INNER_KEYS - middle;
+
+        hi = his[middle];
+        lo = los[middle];
+        child = right;
     }
-}
-void BinarySearchTree::postOrder(Node* node) {
 
-    // If node is not equal to null ptr
-    if (node != nullptr) {
+    // The root split; a new root goes on top
+    BPlusInner* top = new BPlusInner();
+    top->children[0] = root;
+    top->children[1] = child;
+    insertKey(top, 0, hi, lo);
+    root = top;
+    height++;
+}
 
-        // Traverse left side 
-        postOrder(node->leftChild);
+/**
+ * Remove a bid
+ */
+void BPlusTree::Remove(string bidId) {
+    // The first copy of the ID is where it would go, or else first
+    // in the next leaf
+    unsigned int slot;
+    BPlusLeaf* leaf = seek(bidId, false, slot);
+    if (slot == leaf->count && leaf->next != nullptr) {
+        leaf = leaf->next;
+        slot = 0;
+        nextLeaf();
+    }
+    if (slot == leaf->count || leaf->bids[slot].bidId != bidId) {
+        return;
+    }
 
-        // Traverse right side 
-        postOrder(node->rightChild);
+    move(leaf->bids + slot + 1, leaf->bids + leaf->count, leaf->bids + slot);
+    leaf->bids[leaf->count - 1] = Bid();
+    removeKey(leaf, slot);
+    size--;
 
-        // Output bid ID, title, amount, and fund
-        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
-            << node->bid.fund << endl;
+    if (leaf->count == 0 && height > 1) {
+        removeLeaf(leaf);
     }
-
 }
 
-void BinarySearchTree::preOrder(Node* node) {
-
-    // If node is not equal to null ptr
-    if (node != nullptr) {
+/**
+ * Unlink and delete an empty leaf the path leads to, along with
+ * any inner nodes left without children, then drop root levels
+ * that have only one child
+ */
+void BPlusTree::removeLeaf(BPlusLeaf* leaf) {
+    if (leaf->previous != nullptr) {
+        leaf->previous->next = leaf->next;
+    }
+    if (leaf->next != nullptr) {
+        leaf->next->previous = leaf->previous;
+    }
+    delete leaf;
 
-        // Output bid ID, title, amount, and fund
-        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " | "
-            << node->bid.fund << endl;
+    while (!path.empty()) {
+        BPlusInner* inner = path.back().first;
+        unsigned int slot = path.back().second;
+        path.pop_back();
 
-        // Traverse left side 
-        postOrder(node->leftChild);
+        // An inner node losing its only child goes too
+        if (inner->count == 0 && !path.empty()) {
+            delete inner;
+            continue;
+        }
 
-        // Traverse right side 
-        postOrder(node->rightChild);
+        // Otherwise drop the child and the separator on one side of it
+        copy(inner->children + slot + 1, inner->children + inner->count + 1, inner->children + slot);
+        removeKey(inner, slot > 0 ? slot - 1 : 0);
+        break;
     }
-}
 
-Node* BinarySearchTree::removeNode(Node* node, string bidId) {
-
-    // If node is equal to nullptr, return - no bid to remove
-    if (node == nullptr) {
-        return node;
+    while (height > 1 && root->count == 0) {
+        BPlusInner* top = static_cast<BPlusInner*>(root);
+        root = top->children[0];
+        delete top;
+        height--;
     }
+}
 
-    // If bid ID is less than bid ID at node, traverse left side
-    if (bidId.compare(node->bid.bidId) < 0) {
-        node->leftChild = removeNode(node->leftChild, bidId);
+/**
+ * Search for a bid
+ */
+Bid BPlusTree::Search(string bidId) {
+    // The first copy of the ID is where it would go, or else first
+    // in the next leaf
+    unsigned int slot;
+    BPlusLeaf* leaf = seek(bidId, false, slot);
+    if (slot == leaf->count && leaf->next != nullptr) {
+        leaf = leaf->next;
+        slot = 0;
     }
-
-    // If bid ID is greater than bid ID at node, traverse right side
-    else if (bidId.compare(node->bid.bidId) > 0) {
-        node->rightChild = removeNode(node->rightChild, bidId);
+    if (slot < leaf->count && leaf->bids[slot].bidId == bidId) {
+        return leaf->bids[slot];
     }
 
-    else {
-
-        // If node has no children, delete node
-        if (node->leftChild == nullptr && node->rightChild == nullptr) {
-            delete node;
-            node = nullptr;
-        }
-        
-        // If node has only left child, set left child to parent node and delete node
-        else if (node->leftChild != nullptr && node->rightChild == nullptr) {
-            Node* tempNode = node;
-            node = node->leftChild;
-            delete tempNode;
-        }
-        
-        // If node has only right child, set right child to parent node and delete node
-        else if (node->leftChild == nullptr && node->rightChild != nullptr) {
-            Node* tempNode = node;
-            node = node->rightChild;
-            delete tempNode;
-        }
-       
-        // If node has two children
-        else {
+    // Return empty bid if no matching bid found
+    return Bid();
+}
 
-            // Traverse to find leftmost child of right subtree
-            Node* tempNode = node->rightChild;
-            while (tempNode->leftChild != nullptr) {
-                tempNode = tempNode->leftChild;
+/**
+ * Visit every bid with an ID from lo to hi, both included, in
+ * order, walking the leaves from the one holding lo
+ *
+ * @param lo The smallest bid ID to visit
+ * @param hi The largest bid ID to visit
+ * @param visit The function to call with each bid
+ */
+void BPlusTree::RangeScan(string lo, string hi, function<void(const Bid&)> visit) {
+    unsigned int slot;
+    for (BPlusLeaf* leaf = seek(lo, false, slot); leaf != nullptr; leaf = leaf->next, slot = 0) {
+        for (; slot < leaf->count; slot++) {
+            if (leaf->bids[slot].bidId.compare(hi) > 0) {
+                return;
             }
+            visit(leaf->bids[slot]);
+        }
+    }
+}
 
-            // Copy bid, then remove duplicate child
-            node->bid = tempNode->bid;
-            node->rightChild = removeNode(node->rightChild, tempNode->bid.bidId);
+/**
+ * Traverse the tree in order, along the leaves
+ */
+void BPlusTree::InOrder() {
+    for (BPlusLeaf* leaf = leftmostLeaf(); leaf != nullptr; leaf = leaf->next) {
+        for (unsigned int i = 0; i < leaf->count; i++) {
+            const Bid& bid = leaf->bids[i];
+
+            // Output bid ID, title, amount, and fund
+            cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
+                << funds.lookup(bid.fundId) << endl;
         }
     }
+}
 
-    // Return node 
-    return node;
+/**
+ * Number of bids in the tree
+ */
+unsigned int BPlusTree::Size() {
+    return size;
+}
+
+/**
+ * Number of levels in the tree
+ */
+unsigned int BPlusTree::Height() {
+    return height;
 }
 
 
@@ -341,21 +1404,71 @@ Node* BinarySearchTree::removeNode(Node* node, string bidId) {
  */
 void displayBid(Bid bid) {
     cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-        << bid.fund << endl;
+        << funds.lookup(bid.fundId) << endl;
     return;
 }
 
+/**
+ * Load bids from the binary snapshot written by an earlier CSV load
+ *
+ * @param snapshotPath the path to the snapshot file
+ * @param csvPath the CSV file the snapshot must still match
+ * @return false if there is no usable snapshot
+ */
+bool loadSnapshot(string snapshotPath, string csvPath, BidIndex* bst) {
+    // no snapshot yet is the usual first run, not a failure
+    if (!filesystem::exists(snapshotPath)) {
+        return false;
+    }
+
+    try {
+        csv::Snapshot snapshot(snapshotPath, csvPath);
+
+        for (unsigned int i = 0; i < snapshot.rowCount(); i++) {
+            Bid bid;
+            bid.bidId = snapshot.text(i, 0);
+            bid.title = snapshot.text(i, 1);
+            bid.fundId = funds.intern(snapshot.text(i, 2));
+            bid.amount = snapshot.number(i, 0);
+            bst->Insert(bid);
+        }
+    }
+    catch (csv::Error& e) {
+        cout << e.what() << ", reading CSV instead" << endl;
+        return false;
+    }
+
+    cout << "Loaded snapshot " << snapshotPath << endl;
+    return true;
+}
+
 /**
  * Load a CSV file containing bids into a container
  *
  * @param csvPath the path to the CSV file to load
  * @return a container holding all the bids read
  */
-void loadBids(string csvPath, BinarySearchTree* bst) {
+void loadBids(string csvPath, BidIndex* bst) {
+    // a current snapshot from an earlier load skips text parsing entirely
+    string snapshotPath = csvPath + ".snap";
+    if (loadSnapshot(snapshotPath, csvPath, bst)) {
+        return;
+    }
+
     cout << "Loading CSV file " << csvPath << endl;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // initialize the CSV Reader, which streams the file one block at a time
+    csv::Reader file(csvPath);
+
+    // bind the CSV columns to Bid fields once, checked against the header here
+    auto binder = csv::makeBinder(file.getHeader(),
+        csv::bind(1, &Bid::bidId, csv::AsString()),
+        csv::bind(0, &Bid::title, csv::AsString()),
+        csv::bind(8, &Bid::fundId, csv::AsInterned(funds)),
+        csv::bind(4, &Bid::amount, csv::AsCurrency()));
+
+    // only the bound columns are parsed, the others are skipped
+    file.project(binder.columns());
 
     // read and display header row - optional
     vector<string> header = file.getHeader();
@@ -364,22 +1477,27 @@ void loadBids(string csvPath, BinarySearchTree* bst) {
     }
     cout << "" << endl;
 
+    // remember what is read so the next load can map it instead
+    csv::SnapshotWriter snapshot(3, 1);
+
     try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+        // hand each row of the CSV file straight to the container
+        file.forEachRow([&](const csv::Row& row) {
 
-            // Create a data structure and add to the collection of bids
+            // fill a bid straight from the field views, no temporary strings
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+            binder.fill(row, bid);
+
+            // record the same fields for the snapshot
+            snapshot.add({ row.view(1), row.view(0), row.view(8) }, { bid.amount });
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+            //cout << "Item: " << bid.title << ", Fund: " << funds.lookup(bid.fundId) << ", Amount: " << bid.amount << endl;
 
             // push this bid to the end
             bst->Insert(bid);
-        }
+        });
+
+        snapshot.write(snapshotPath, csvPath);
     }
     catch (csv::Error& e) {
         std::cerr << e.what() << std::endl;
@@ -387,16 +1505,349 @@ void loadBids(string csvPath, BinarySearchTree* bst) {
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Display the time per operation of a timed loop
+ *
+ * @param label what was timed
+ * @param ticks clock ticks the loop took
+ * @param operations how many operations the loop did
+ */
+void displayTime(string label, clock_t ticks, unsigned int operations) {
+    cout << "  " << label << ": " << ticks * 1.0e9 / CLOCKS_PER_SEC / operations << " ns/op" << endl;
+}
+
+/**
+ * Insert bids in sorted, reverse sorted and random order into
+ * an unbalanced and an AVL tree, then search for every one of
+ * them in random order
+ *
+ * @param count the number of bids to insert
+ */
+void benchmarkBalancing(unsigned int count) {
+    vector<Bid> sorted(count);
+    for (unsigned int i = 0; i < count; i++) {
+        sorted[i].bidId = to_string(10000000 + i);
+        sorted[i].title = "Bid " + sorted[i].bidId;
+    }
+    vector<Bid> reversed(sorted.rbegin(), sorted.rend());
+    vector<Bid> shuffled(sorted);
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(count));
+
+    const vector<Bid>* orders[] = { &sorted, &reversed, &shuffled };
+    const char* labels[] = { "sorted", "reverse sorted", "random" };
+
+    for (unsigned int o = 0; o < 3; o++) {
+        for (Balancing balancing : { eNONE, eAVL }) {
+            BinarySearchTree tree(balancing);
+
+            clock_t ticks = clock();
+            for (const Bid& bid : *orders[o]) {
+                tree.Insert(bid);
+            }
+            ticks = clock() - ticks;
+            cout << labels[o] << ", " << (balancing == eAVL ? "AVL" : "unbalanced") << ": height "
+                << tree.Height() << endl;
+            displayTime("insert", ticks, count);
+
+            unsigned int found = 0;
+            ticks = clock();
+            for (const Bid& bid : shuffled) {
+                found += !tree.Search(bid.bidId).bidId.empty();
+            }
+            displayTime("search", clock() - ticks, count);
+
+            if (found != count) {
+                cout << "  found " << found << " of " << count << " bids" << endl;
+            }
+        }
+    }
+}
+
+/**
+ * Load bids with scattered IDs into an index, then search for
+ * all of them, and as many missing IDs, in another order
+ *
+ * @param label the index's name
+ * @param index the empty index to fill
+ * @param bids the bids to insert
+ * @param bidIds the IDs to search for
+ */
+void timeIndex(string label, BidIndex* index, const vector<Bid>& bids, const vector<string>& bidIds) {
+    clock_t ticks = clock();
+    for (const Bid& bid : bids) {
+        index->Insert(bid);
+    }
+    ticks = clock() - ticks;
+    cout << label << ": height " << index->Height() << endl;
+    displayTime("insert", ticks, bids.size());
+
+    unsigned int found = 0;
+    ticks = clock();
+    for (const string& bidId : bidIds) {
+        found += !index->Search(bidId).bidId.empty();
+    }
+    displayTime("search", clock() - ticks, bidIds.size());
+
+    if (found != bids.size()) {
+        cout << "  found " << found << " of " << bids.size() << " bids" << endl;
+    }
+}
+
+/**
+ * Check an index against bid IDs longer than 16 bytes, many of
+ * them sharing their first 16, inserted out of order, then with
+ * every other one removed
+ *
+ * @param label the index's name
+ * @param index the empty index to fill
+ */
+void checkLongIds(string label, BidIndex* index) {
+    vector<string> bidIds = { "123456789012345", "1234567890123456", "12345678901234560",
+        "12345678901234567", "12345678901234567", "1234567890123456789", "98765432109876543210" };
+    for (unsigned int i = 0; i < 100; i++) {
+        bidIds.push_back("1234567890123456" + to_string(1000 + i * 37 % 100));
+    }
+    shuffle(bidIds.begin(), bidIds.end(), mt19937(bidIds.size()));
+
+    for (const string& bidId : bidIds) {
+        Bid bid;
+        bid.bidId = bidId;
+        index->Insert(bid);
+    }
+    sort(bidIds.begin(), bidIds.end());
+
+    for (unsigned int pass = 0; pass < 2; pass++) {
+        vector<string> scanned;
+        index->RangeScan("", "~", [&](const Bid& bid) { scanned.push_back(bid.bidId); });
+        if (scanned != bidIds) {
+            cout << "  " << label << ": range scan out of order over long bid IDs" << endl;
+        }
+
+        unsigned int found = 0;
+        for (const string& bidId : bidIds) {
+            found += index->Search(bidId).bidId == bidId;
+        }
+        if (found != bidIds.size() || !index->Search("12345678901234569").bidId.empty()) {
+            cout << "  " << label << ": found " << found << " of " << bidIds.size() << " long bid IDs" << endl;
+        }
+
+        // drop every other bid, IDs sharing a key among them
+        vector<string> kept;
+        for (unsigned int i = 0; i < bidIds.size(); i++) {
+            if (i % 2 == 0) {
+                index->Remove(bidIds[i]);
+            }
+            else {
+                kept.push_back(bidIds[i]);
+            }
+        }
+        bidIds.swap(kept);
+    }
+}
+
+/**
+ * Compare the AVL tree with the B+ tree over a large set of bids
+ *
+ * @param count the number of bids
+ */
+void benchmarkIndexes(unsigned int count) {
+    vector<Bid> bids(count);
+    vector<string> bidIds;
+    for (unsigned int i = 0; i < count; i++) {
+        bids[i].bidId = to_string(10000000 + i * 48271ULL % 90000000);
+        bids[i].title = "Bid " + bids[i].bidId;
+        bidIds.push_back(bids[i].bidId);
+        bidIds.push_back(to_string(i)); // too short to be any bid's ID
+    }
+    shuffle(bidIds.begin(), bidIds.end(), mt19937(count));
+
+    BidIndex* indexes[] = { new BinarySearchTree(eAVL), new BPlusTree() };
+    const char* labels[] = { "BinarySearchTree (AVL)", "BPlusTree" };
+    for (unsigned int i = 0; i < 2; i++) {
+        timeIndex(labels[i], indexes[i], bids, bidIds);
+        delete indexes[i];
+    }
+
+    BinarySearchTree tree(eAVL);
+    BPlusTree bPlusTree;
+    checkLongIds(labels[0], &tree);
+    checkLongIds(labels[1], &bPlusTree);
+}
+
+/**
+ * Time building an AVL tree of sorted bids through Insert and
+ * through BulkLoad, and BulkLoad of the same bids shuffled, then
+ * searching each tree and changing it afterwards
+ *
+ * @param count the number of bids
+ */
+void benchmarkBulkLoad(unsigned int count) {
+    vector<Bid> sorted(count);
+    for (unsigned int i = 0; i < count; i++) {
+        sorted[i].bidId = to_string(10000000 + i);
+        sorted[i].title = "Bid " + sorted[i].bidId;
+    }
+    vector<Bid> shuffled(sorted);
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(count));
+
+    const char* labels[] = { "Insert sorted", "BulkLoad sorted", "BulkLoad shuffled" };
+    for (unsigned int i = 0; i < 3; i++) {
+        BinarySearchTree tree(eAVL);
+
+        clock_t ticks = clock();
+        if (i == 0) {
+            for (const Bid& bid : sorted) {
+                tree.Insert(bid);
+            }
+        }
+        else {
+            tree.BulkLoad(i == 1 ? sorted : shuffled);
+        }
+        ticks = clock() - ticks;
+        cout << labels[i] << ": height " << tree.Height() << endl;
+        displayTime("load", ticks, count);
+
+        unsigned int found = 0;
+        ticks = clock();
+        for (const Bid& bid : shuffled) {
+            found += !tree.Search(bid.bidId).bidId.empty();
+        }
+        displayTime("search", clock() - ticks, count);
+        if (found != count) {
+            cout << "  found " << found << " of " << count << " bids" << endl;
+        }
+
+        // the tree takes changes like any other: drop every other
+        // bid, then put back every fourth
+        for (unsigned int j = 0; j < count; j += 2) {
+            tree.Remove(sorted[j].bidId);
+        }
+        for (unsigned int j = 0; j < count; j += 4) {
+            tree.Insert(sorted[j]);
+        }
+        if (tree.Size() != count / 2 + (count + 3) / 4) {
+            cout << "  " << tree.Size() << " bids left after changes" << endl;
+        }
+    }
+}
+
+/**
+ * Whether an iterator is at a place in a sorted list of bid IDs,
+ * judged by the IDs at and just before it
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param tree the tree the iterator walks
+ * @param it the iterator
+ * @param bidIds every ID in the tree, sorted
+ * @param place the index in bidIds, or its size for end()
+ */
+bool isAt(const BinarySearchTree& tree, BinarySearchTree::iterator it, const vector<string>& bidIds, size_t place) {
+    if (place == bidIds.size() ? it != tree.end() : it == tree.end() || it->bidId != bidIds[place]) {
+        return false;
+    }
+    if (place == 0) {
+        return it == tree.begin();
+    }
+    return it != tree.begin() && (--it)->bidId == bidIds[place - 1];
+}
+
+/**
+ * Walk an AVL tree of shuffled bids, some of them copies, with its
+ * iterators forwards and backwards, from lower_bound and
+ * upper_bound at present and missing IDs, and through RangeScan,
+ * checking each against the sorted IDs, then time RangeScan on the
+ * AVL tree and the B+ tree
  *
- * @param ch The character to strip out
+ * @param count the number of bids
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+void benchmarkRangeScan(unsigned int count) {
+    // even IDs only, so odd ones are missing; every tenth bid twice
+    vector<Bid> bids;
+    for (unsigned int i = 0; i < count; i++) {
+        Bid bid;
+        bid.bidId = to_string(10000000 + 2 * i);
+        bid.title = "Bid " + bid.bidId;
+        bids.push_back(bid);
+        if (i % 10 == 0) {
+            bids.push_back(bid);
+        }
+    }
+    shuffle(bids.begin(), bids.end(), mt19937(count));
+
+    vector<string> bidIds;
+    BinarySearchTree tree(eAVL);
+    BPlusTree bPlusTree;
+    for (const Bid& bid : bids) {
+        bidIds.push_back(bid.bidId);
+        tree.Insert(bid);
+        bPlusTree.Insert(bid);
+    }
+    sort(bidIds.begin(), bidIds.end());
+
+    clock_t ticks = clock();
+    vector<string> walked;
+    for (BinarySearchTree::iterator it = tree.begin(); it != tree.end(); ++it) {
+        walked.push_back(it->bidId);
+    }
+    displayTime("walk forwards", clock() - ticks, bids.size());
+    if (walked != bidIds) {
+        cout << "  forward walk out of order" << endl;
+    }
+
+    walked.clear();
+    for (BinarySearchTree::iterator it = tree.end(); it != tree.begin();) {
+        walked.push_back((--it)->bidId);
+    }
+    reverse(walked.begin(), walked.end());
+    if (walked != bidIds) {
+        cout << "  backward walk out of order" << endl;
+    }
+
+    // each range spans about 100 bids and starts at a present or
+    // missing ID, alternately
+    const unsigned int ranges = 1000;
+    vector<pair<string, string> > bounds;
+    mt19937 random(ranges);
+    for (unsigned int i = 0; i < ranges; i++) {
+        unsigned long long first = 10000000 + random() % (2ULL * count + 200) + i % 2;
+        bounds.push_back(make_pair(to_string(first), to_string(first + 200)));
+    }
+
+    unsigned int misplaced = 0;
+    for (const pair<string, string>& range : bounds) {
+        size_t lower = std::lower_bound(bidIds.begin(), bidIds.end(), range.first) - bidIds.begin();
+        size_t upper = std::upper_bound(bidIds.begin(), bidIds.end(), range.first) - bidIds.begin();
+        misplaced += !isAt(tree, tree.lower_bound(range.first), bidIds, lower);
+        misplaced += !isAt(tree, tree.upper_bound(range.first), bidIds, upper);
+    }
+    if (misplaced > 0) {
+        cout << "  " << misplaced << " of " << 2 * ranges << " bounds misplaced" << endl;
+    }
+
+    BidIndex* indexes[] = { &tree, &bPlusTree };
+    const char* labels[] = { "BinarySearchTree (AVL)", "BPlusTree" };
+    for (unsigned int i = 0; i < 2; i++) {
+        vector<vector<string> > scans(ranges);
+        unsigned int scanned = 0;
+        ticks = clock();
+        for (unsigned int r = 0; r < ranges; r++) {
+            indexes[i]->RangeScan(bounds[r].first, bounds[r].second, [&](const Bid& bid) {
+                scans[r].push_back(bid.bidId);
+            });
+            scanned += scans[r].size();
+        }
+        ticks = clock() - ticks;
+        cout << labels[i] << ": " << ranges << " ranges, " << scanned << " bids" << endl;
+        displayTime("range scan", ticks, ranges);
+
+        unsigned int wrong = 0;
+        for (unsigned int r = 0; r < ranges; r++) {
+            vector<string>::iterator first = std::lower_bound(bidIds.begin(), bidIds.end(), bounds[r].first);
+            vector<string>::iterator last = std::upper_bound(bidIds.begin(), bidIds.end(), bounds[r].second);
+            wrong += scans[r] != vector<string>(first, last);
+        }
+        if (wrong > 0) {
+            cout << "  " << wrong << " of " << ranges << " ranges scanned wrong" << endl;
+        }
+    }
 }
 
 /**
@@ -423,11 +1874,15 @@ int main(int argc, char* argv[]) {
     // Define a timer variable
     clock_t ticks;
 
-    // Define a binary search tree to hold all bids
-    BinarySearchTree* bst = nullptr;
+    // Define a B+ tree to hold all bids
+    BidIndex* bst = nullptr;
 
     Bid bid;
 
+    // Bounds and count of a range search
+    string firstKey, lastKey;
+    unsigned int found;
+
     int choice = 0;
     while (choice != 9) {
         cout << "Menu:" << endl;
@@ -435,6 +1890,11 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Benchmark Balancing" << endl;
+        cout << "  6. Benchmark B+ Tree" << endl;
+        cout << "  7. Find Bids In Range" << endl;
+        cout << "  8. Benchmark Bulk Load" << endl;
+        cout << " 10. Benchmark Range Scans" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -442,7 +1902,7 @@ int main(int argc, char* argv[]) {
         switch (choice) {
 
         case 1:
-            bst = new BinarySearchTree();
+            bst = new BPlusTree();
 
             // Initialize a timer variable before loading bids
             ticks = clock();
@@ -450,7 +1910,7 @@ int main(int argc, char* argv[]) {
             // Complete the method call to load the bids
             loadBids(csvPath, bst);
 
-            //cout << bst->Size() << " bids read" << endl;
+            cout << bst->Size() << " bids read" << endl;
 
             // Calculate elapsed time and display result
             ticks = clock() - ticks; // current clock ticks minus starting clock ticks
@@ -484,6 +1944,39 @@ int main(int argc, char* argv[]) {
         case 4:
             bst->Remove(bidKey);
             break;
+
+        case 5:
+            benchmarkBalancing(10000);
+            break;
+
+        case 6:
+            benchmarkIndexes(1000000);
+            break;
+
+        case 7:
+            cout << "Enter first and last bid Id: ";
+            cin >> firstKey >> lastKey;
+
+            ticks = clock();
+            found = 0;
+            bst->RangeScan(firstKey, lastKey, [&](const Bid& inRange) {
+                displayBid(inRange);
+                found++;
+            });
+            ticks = clock() - ticks; // current clock ticks minus starting clock ticks
+
+            cout << found << " bids from " << firstKey << " to " << lastKey << endl;
+            cout << "time: " << ticks << " clock ticks" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
+
+        case 8:
+            benchmarkBulkLoad(1000000);
+            break;
+
+        case 10:
+            benchmarkRangeScan(1000000);
+            break;
         }
     }
 
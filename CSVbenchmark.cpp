@@ -0,0 +1,332 @@
+//============================================================================
+// Name        : CSVbenchmark.cpp
+// Author      : Paul Kenaga
+// Version     : 1.0
+// Copyright   : Copyright © 2017 SNHU COCE
+// Description : Timing harness for the CSV parser
+//============================================================================
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CSVparser.hpp"
+
+using namespace std;
+
+//============================================================================
+// Global definitions visible to all methods and classes
+//============================================================================
+
+const char* FUNDS[] = { "General Fund", "Enterprise", "Special Revenue", "Capital Projects", "Trust" };
+
+// every heap allocation in this program is counted so loads can report it
+atomic<unsigned long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+// GCC can't tell these replace the global operators and warns about
+// free() on memory from operator new
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+//============================================================================
+// Static methods used for benchmarking
+//============================================================================
+
+/**
+ * Write a synthetic eBid export with the same nine columns as the
+ * monthly sales files, including quoted titles and amounts
+ *
+ * @param csvPath the path to write to
+ * @param rows number of bid rows to generate
+ */
+void generateBids(string csvPath, unsigned int rows) {
+    ofstream out(csvPath.c_str(), ios::out | ios::trunc);
+    out << "ArticleTitle,ArticleID,Department,CloseDate,WinningBid,InventoryID,VehicleID,ReceiptNumber,Fund\n";
+
+    for (unsigned int i = 0; i < rows; i++) {
+        if (i % 7 == 0) {
+            out << "\"Surplus item, lot " << i << "\"";
+        }
+        else {
+            out << "Surplus item " << i;
+        }
+        out << "," << 10000 + i << ",Dept " << i % 12 << ",12/" << i % 28 + 1 << "/2016,"
+            << "\"$" << i % 4 << "," << i % 1000 << "." << i % 100 << "\","
+            << "INV" << i << ",,R" << i << "," << FUNDS[i % 5] << "\n";
+    }
+}
+
+/**
+ * The parse loop csv::Parser used before the tokenizer: getline into
+ * strings, then a bounds-checked walk and a substr copy per field
+ *
+ * @param csvPath the path to the CSV file to parse
+ * @return number of data rows parsed
+ */
+unsigned int legacyParse(string csvPath) {
+    ifstream in(csvPath.c_str());
+    vector<string> lines;
+    string line;
+
+    while (getline(in, line)) {
+        if (line != "") {
+            lines.push_back(line);
+        }
+    }
+
+    vector<vector<string> > rows;
+    for (unsigned int r = 1; r < lines.size(); r++) {
+        const string& l = lines[r];
+        vector<string> row;
+        bool quoted = false;
+        int tokenStart = 0;
+
+        for (unsigned int i = 0; i != l.length(); i++) {
+            if (l.at(i) == '"') {
+                quoted = !quoted;
+            }
+            else if (l.at(i) == ',' && !quoted) {
+                row.push_back(l.substr(tokenStart, i - tokenStart));
+                tokenStart = i + 1;
+            }
+        }
+        row.push_back(l.substr(tokenStart, l.length() - tokenStart));
+        rows.push_back(row);
+    }
+    return rows.size();
+}
+
+/**
+ * Wall-clock seconds since start; clock() would add up CPU time
+ * across threads and hide any parallel speedup
+ */
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Display one timing result
+ *
+ * @param label what was timed
+ * @param rows number of rows parsed
+ * @param seconds elapsed wall-clock time
+ */
+void report(string label, unsigned int rows, double seconds) {
+    cout << label << ": " << rows << " rows, " << seconds << " seconds" << endl;
+}
+
+/**
+ * Time a csv::Parser load with the given scan mode and data type
+ *
+ * @return number of rows parsed, or 0 if the mode is unsupported
+ */
+unsigned int timeParser(string label, string csvPath, csv::ScanMode mode, csv::DataType type) {
+    if (!csv::setScanMode(mode)) {
+        cout << label << ": not supported on this CPU" << endl;
+        return 0;
+    }
+
+    unsigned long long before = allocations;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    csv::Parser file = csv::Parser(csvPath, type);
+    double seconds = secondsSince(start);
+
+    report(label, file.rowCount(), seconds);
+    cout << "  " << allocations - before << " allocations" << endl;
+    return file.rowCount();
+}
+
+/**
+ * The amount conversion every loader used before csv::parseCurrency:
+ * copy the field, erase the '$' in place, then atof
+ */
+double legacyStrToDouble(string str, char ch) {
+    str.erase(remove(str.begin(), str.end(), ch), str.end());
+    return atof(str.c_str());
+}
+
+/**
+ * The stringstream conversion Row::getValue used before csv::convert
+ */
+int legacyGetValue(string_view text) {
+    int res;
+    stringstream ss;
+    ss << text;
+    ss >> res;
+    return res;
+}
+
+/**
+ * Time the old and new field conversions over the amount and id
+ * columns. Sums are printed so the work can't be optimized away.
+ *
+ * @param file parser holding the generated bids
+ */
+void timeConversions(const csv::Parser& file) {
+    const unsigned int REPEAT = 5;
+    unsigned int count = file.rowCount() * REPEAT;
+    chrono::steady_clock::time_point start;
+    double sum = 0.0;
+    long long cents = 0;
+    long long ids = 0;
+
+    start = chrono::steady_clock::now();
+    for (unsigned int r = 0; r < REPEAT; r++) {
+        for (unsigned int i = 0; i < file.rowCount(); i++) {
+            sum += legacyStrToDouble(file[i][4], '$');
+        }
+    }
+    report("legacy strToDouble", count, secondsSince(start));
+    cout << "  sum " << sum << endl;
+
+    sum = 0.0;
+    start = chrono::steady_clock::now();
+    for (unsigned int r = 0; r < REPEAT; r++) {
+        for (unsigned int i = 0; i < file.rowCount(); i++) {
+            double amount = 0.0;
+            csv::parseCurrency(file[i].view(4), amount);
+            sum += amount;
+        }
+    }
+    report("csv::parseCurrency", count, secondsSince(start));
+    cout << "  sum " << sum << endl;
+
+    start = chrono::steady_clock::now();
+    for (unsigned int r = 0; r < REPEAT; r++) {
+        for (unsigned int i = 0; i < file.rowCount(); i++) {
+            long long amount = 0;
+            csv::parseCents(file[i].view(4), amount);
+            cents += amount;
+        }
+    }
+    report("csv::parseCents", count, secondsSince(start));
+    cout << "  sum " << cents / 100 << "." << cents % 100 << endl;
+
+    start = chrono::steady_clock::now();
+    for (unsigned int r = 0; r < REPEAT; r++) {
+        for (unsigned int i = 0; i < file.rowCount(); i++) {
+            ids += legacyGetValue(file[i].view(1));
+        }
+    }
+    report("legacy getValue<int>", count, secondsSince(start));
+    cout << "  sum " << ids << endl;
+
+    ids = 0;
+    start = chrono::steady_clock::now();
+    for (unsigned int r = 0; r < REPEAT; r++) {
+        for (unsigned int i = 0; i < file.rowCount(); i++) {
+            ids += file[i].getValue<int>(1);
+        }
+    }
+    report("getValue<int>", count, secondsSince(start));
+    cout << "  sum " << ids << endl;
+}
+
+/**
+ * Check that two parsers produced the same rows in the same order
+ *
+ * @return true if every field matches
+ */
+bool sameRows(const csv::Parser& a, const csv::Parser& b) {
+    if (a.rowCount() != b.rowCount()) {
+        return false;
+    }
+    for (unsigned int i = 0; i < a.rowCount(); i++) {
+        for (unsigned int j = 0; j < a.columnCount(); j++) {
+            if (a[i].view(j) != b[i].view(j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * The one and only main() method
+ *
+ * @param arg[1] number of rows to generate (optional)
+ * @param arg[2] path of the generated CSV file (optional)
+ */
+int main(int argc, char* argv[]) {
+
+    // process command line arguments
+    unsigned int rows = 1000000;
+    string csvPath = "eBid_benchmark.csv";
+    if (argc > 1) {
+        rows = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        csvPath = argv[2];
+    }
+
+    cout << "Generating " << rows << " bids in " << csvPath << endl;
+    generateBids(csvPath, rows);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    unsigned int expected = legacyParse(csvPath);
+    report("legacy loop", expected, secondsSince(start));
+
+    try {
+        unsigned int counts[] = {
+            timeParser("scalar eFILE", csvPath, csv::eSCAN_SCALAR, csv::eFILE),
+            timeParser("scalar eMMAP", csvPath, csv::eSCAN_SCALAR, csv::eMMAP),
+            timeParser("SSE2   eFILE", csvPath, csv::eSCAN_SSE2, csv::eFILE),
+            timeParser("SSE2   eMMAP", csvPath, csv::eSCAN_SSE2, csv::eMMAP),
+            timeParser("AVX2   eFILE", csvPath, csv::eSCAN_AVX2, csv::eFILE),
+            timeParser("AVX2   eMMAP", csvPath, csv::eSCAN_AVX2, csv::eMMAP),
+            timeParser("auto   ePARALLEL", csvPath, csv::eSCAN_AUTO, csv::ePARALLEL),
+            timeParser("auto   eARENA", csvPath, csv::eSCAN_AUTO, csv::eARENA)
+        };
+
+        for (unsigned int count : counts) {
+            if (count != 0 && count != expected) {
+                cout << "row count mismatch: " << count << " != " << expected << endl;
+                return 1;
+            }
+        }
+
+        // the parallel and arena parsers must match the serial one row for row
+        csv::Parser serial = csv::Parser(csvPath, csv::eMMAP);
+        csv::Parser parallel = csv::Parser(csvPath, csv::ePARALLEL);
+        if (!sameRows(serial, parallel)) {
+            cout << "ePARALLEL rows differ from eMMAP" << endl;
+            return 1;
+        }
+        csv::Parser arena = csv::Parser(csvPath, csv::eARENA);
+        if (!sameRows(serial, arena)) {
+            cout << "eARENA rows differ from eMMAP" << endl;
+            return 1;
+        }
+
+        timeConversions(serial);
+    }
+    catch (csv::Error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
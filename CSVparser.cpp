@@ -1,15 +1,807 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <thread>
 #include "CSVparser.hpp"
 
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+# define CSV_SCAN_X86
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  define CSV_TARGET(isa)
+# else
+#  define CSV_TARGET(isa) __attribute__((target(isa)))
+# endif
+#endif
+
 namespace csv {
 
+  /*
+  ** TOKENIZER
+  **
+  ** Stage one finds the offset of every separator, quote and newline in
+  ** a block; stage two walks those offsets to build field and record
+  ** boundaries. Only stage one depends on the instruction set.
+  */
+
+  namespace {
+
+    typedef std::size_t (*FindFunc)(const char *, std::size_t, char, std::uint32_t *);
+
+    std::size_t findScalar(const char *p, std::size_t n, char sep, std::uint32_t *out)
+    {
+        std::size_t count = 0;
+
+        for (std::size_t i = 0; i < n; i++)
+        {
+            char c = p[i];
+            if (c == sep || c == '"' || c == '\n')
+                out[count++] = static_cast<std::uint32_t>(i);
+        }
+        return count;
+    }
+
+#ifdef CSV_SCAN_X86
+    inline unsigned lowestBit(unsigned mask)
+    {
+# ifdef _MSC_VER
+        unsigned long pos;
+        _BitScanForward(&pos, mask);
+        return pos;
+# else
+        return __builtin_ctz(mask);
+# endif
+    }
+
+    CSV_TARGET("sse2")
+    std::size_t findSSE2(const char *p, std::size_t n, char sep, std::uint32_t *out)
+    {
+        const __m128i vsep = _mm_set1_epi8(sep);
+        const __m128i vquote = _mm_set1_epi8('"');
+        const __m128i vnl = _mm_set1_epi8('\n');
+        std::size_t count = 0;
+        std::size_t i = 0;
+
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, vsep),
+                                                     _mm_cmpeq_epi8(block, vquote)),
+                                        _mm_cmpeq_epi8(block, vnl));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+
+            while (mask != 0)
+            {
+                out[count++] = static_cast<std::uint32_t>(i + lowestBit(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        std::size_t tail = findScalar(p + i, n - i, sep, out + count);
+        for (std::size_t k = count; k < count + tail; k++)
+            out[k] += static_cast<std::uint32_t>(i);
+        return count + tail;
+    }
+
+    CSV_TARGET("avx2")
+    std::size_t findAVX2(const char *p, std::size_t n, char sep, std::uint32_t *out)
+    {
+        const __m256i vsep = _mm256_set1_epi8(sep);
+        const __m256i vquote = _mm256_set1_epi8('"');
+        const __m256i vnl = _mm256_set1_epi8('\n');
+        std::size_t count = 0;
+        std::size_t i = 0;
+
+        for (; i + 32 <= n; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+            __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, vsep),
+                                                           _mm256_cmpeq_epi8(block, vquote)),
+                                           _mm256_cmpeq_epi8(block, vnl));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+
+            while (mask != 0)
+            {
+                out[count++] = static_cast<std::uint32_t>(i + lowestBit(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        std::size_t tail = findSSE2(p + i, n - i, sep, out + count);
+        for (std::size_t k = count; k < count + tail; k++)
+            out[k] += static_cast<std::uint32_t>(i);
+        return count + tail;
+    }
+
+    bool cpuHasAVX2(void)
+    {
+# ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        // the OS must save the YMM registers (OSXSAVE + XCR0 bits 1-2)
+        if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+# else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+# endif
+    }
+#endif
+
+    FindFunc findFor(ScanMode mode)
+    {
+        switch (mode)
+        {
+#ifdef CSV_SCAN_X86
+          case eSCAN_AVX2:
+            return cpuHasAVX2() ? findAVX2 : nullptr;
+          case eSCAN_SSE2:
+            return findSSE2;
+          case eSCAN_AUTO:
+            return cpuHasAVX2() ? findAVX2 : findSSE2;
+#else
+          case eSCAN_AUTO:
+            return findScalar;
+#endif
+          case eSCAN_SCALAR:
+            return findScalar;
+          default:
+            return nullptr;
+        }
+    }
+
+    std::atomic<ScanMode> g_scanMode(eSCAN_AUTO);
+    std::atomic<FindFunc> g_find(findFor(eSCAN_AUTO));
+
+    /*
+    ** Splits a buffer into records and fields. Quotes toggle the quoted
+    ** state and are kept in the field, as the original per-character
+    ** loop did; separators and newlines inside quotes are plain data.
+    */
+    class FieldScanner
+    {
+      public:
+        FieldScanner(char sep)
+          : _sep(sep), _find(g_find.load(std::memory_order_relaxed)),
+            _positions(BLOCK_SIZE)
+        {
+        }
+
+        // calls onRecord(record, fields) for every non-empty record and
+        // returns how many bytes were consumed; without flush a trailing
+        // record with no newline is left for the next call
+        template<typename Func>
+        std::size_t scan(const char *data, std::size_t size, Func onRecord, bool flush = true)
+        {
+            bool quoted = false;
+            std::size_t fieldStart = 0;
+            std::size_t recordStart = 0;
+
+            _fields.clear();
+            for (std::size_t base = 0; base < size; base += BLOCK_SIZE)
+            {
+                std::size_t len = std::min(BLOCK_SIZE, size - base);
+                std::size_t count = _find(data + base, len, _sep, _positions.data());
+
+                for (std::size_t k = 0; k < count; k++)
+                {
+                    std::size_t pos = base + _positions[k];
+                    char c = data[pos];
+
+                    if (c == '"')
+                        quoted = !quoted;
+                    else if (quoted)
+                        continue;
+                    else if (c == _sep)
+                    {
+                        _fields.push_back(std::string_view(data + fieldStart, pos - fieldStart));
+                        fieldStart = pos + 1;
+                    }
+                    else
+                    {
+                        endRecord(data, recordStart, fieldStart, pos, onRecord);
+                        recordStart = fieldStart = pos + 1;
+                    }
+                }
+            }
+            if (flush && recordStart < size)
+            {
+                endRecord(data, recordStart, fieldStart, size, onRecord);
+                recordStart = size;
+            }
+            return recordStart;
+        }
+
+      private:
+        template<typename Func>
+        void endRecord(const char *data, std::size_t recordStart, std::size_t fieldStart,
+                       std::size_t end, Func &onRecord)
+        {
+            if (end > fieldStart && data[end - 1] == '\r')
+                end--;
+            if (end > recordStart)
+            {
+                _fields.push_back(std::string_view(data + fieldStart, end - fieldStart));
+                onRecord(std::string_view(data + recordStart, end - recordStart), _fields);
+            }
+            _fields.clear();
+        }
+
+      private:
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        const char _sep;
+        const FindFunc _find;
+        std::vector<std::uint32_t> _positions;
+        std::vector<std::string_view> _fields;
+    };
+
+    // offset just past the first newline at or after pos that is not
+    // inside quotes, given the quote state at pos
+    std::size_t recordEnd(const char *data, std::size_t size, std::size_t pos, bool quoted)
+    {
+        for (; pos < size; pos++)
+        {
+            if (data[pos] == '"')
+                quoted = !quoted;
+            else if (data[pos] == '\n' && !quoted)
+                return pos + 1;
+        }
+        return size;
+    }
+
+    void splitHeader(std::string_view line, char sep, std::vector<std::string> &header)
+    {
+        std::stringstream ss{std::string(line)};
+        std::string item;
+
+        while (std::getline(ss, item, sep))
+            header.push_back(item);
+    }
+
+    std::vector<unsigned int> columnsByName(const std::vector<std::string> &header,
+                                            const std::vector<std::string> &names)
+    {
+        std::vector<unsigned int> columns;
+
+        for (auto it = names.begin(); it != names.end(); it++)
+        {
+            auto found = std::find(header.begin(), header.end(), *it);
+            if (found == header.end())
+                throw Error(std::string("can't project this column (doesn't exist) : ").append(*it));
+            columns.push_back(static_cast<unsigned int>(found - header.begin()));
+        }
+        return columns;
+    }
+
+    // maps every column to its slot among the projected ones, or -1
+    std::vector<int> projectionSlots(const std::vector<std::string> &header,
+                                     const std::vector<unsigned int> &columns)
+    {
+        std::vector<bool> keep(header.size(), false);
+        std::vector<int> slots(header.size(), -1);
+        int next = 0;
+
+        for (auto it = columns.begin(); it != columns.end(); it++)
+        {
+            if (*it >= header.size())
+                throw Error("can't project this column (doesn't exist)");
+            keep[*it] = true;
+        }
+        for (std::size_t i = 0; i < keep.size(); i++)
+            if (keep[i])
+                slots[i] = next++;
+        return slots;
+    }
+
+    // stores only the projected fields; skipped ones are never touched
+    void pushFields(Row &row, const std::vector<std::string_view> &fields,
+                    const Schema &schema)
+    {
+        if (!schema.projected())
+        {
+            row.reserve(fields.size());
+            for (std::size_t i = 0; i < fields.size(); i++)
+                row.pushView(fields[i]);
+            return;
+        }
+        for (std::size_t i = 0; i < fields.size(); i++)
+            if (schema.slot(i) >= 0)
+                row.pushView(fields[i]);
+    }
+  }
+
+  bool setScanMode(ScanMode mode)
+  {
+      FindFunc find = findFor(mode);
+      if (find == nullptr)
+        return false;
+      g_find.store(find);
+      g_scanMode.store(mode);
+      return true;
+  }
+
+  ScanMode scanMode(void)
+  {
+      return g_scanMode.load();
+  }
+
+  /*
+  ** CONVERSION
+  */
+
+  namespace {
+
+    // strips spaces, surrounding quotes, a sign and a leading '$',
+    // leaving the digits, thousands separators and decimal point
+    ConvertError currencyDigits(std::string_view &text, bool &negative)
+    {
+        negative = false;
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            text.remove_suffix(1);
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+            text = text.substr(1, text.size() - 2);
+        if (!text.empty() && (text.front() == '-' || text.front() == '+'))
+        {
+            negative = (text.front() == '-');
+            text.remove_prefix(1);
+        }
+        if (!text.empty() && text.front() == '$')
+            text.remove_prefix(1);
+        if (!text.empty() && !negative && text.front() == '-')
+        {
+            negative = true;
+            text.remove_prefix(1);
+        }
+        if (text.empty())
+            return eCONVERT_EMPTY;
+
+        bool digit = false;
+        bool point = false;
+        for (std::size_t i = 0; i < text.size(); i++)
+        {
+            char c = text[i];
+            if (c >= '0' && c <= '9')
+                digit = true;
+            else if (c == '.' && !point)
+                point = true;
+            else if (c != ',' || point)
+                return eCONVERT_SYNTAX;
+        }
+        return digit ? eCONVERT_OK : eCONVERT_SYNTAX;
+    }
+  }
+
+  const char *convertErrorString(ConvertError error)
+  {
+      switch (error)
+      {
+        case eCONVERT_OK:
+          return "ok";
+        case eCONVERT_EMPTY:
+          return "empty value";
+        case eCONVERT_SYNTAX:
+          return "not a number";
+        case eCONVERT_RANGE:
+          return "number out of range";
+      }
+      return "unknown conversion error";
+  }
+
+  void throwConvertError(ConvertError error, std::string_view text)
+  {
+      throw Error(std::string("can't convert value \"").append(text).append("\" : ")
+                  .append(convertErrorString(error)));
+  }
+
+  ConvertError parseCurrency(std::string_view text, double &value)
+  {
+      bool negative;
+      ConvertError error = currencyDigits(text, negative);
+      if (error != eCONVERT_OK)
+        return error;
+
+      // copy the digits without separators to the stack for from_chars
+      char digits[64];
+      std::size_t n = 0;
+      for (std::size_t i = 0; i < text.size(); i++)
+      {
+        if (text[i] == ',')
+          continue;
+        if (n == sizeof(digits))
+          return eCONVERT_RANGE;
+        digits[n++] = text[i];
+      }
+
+      double result;
+      std::from_chars_result r = std::from_chars(digits, digits + n, result);
+      if (r.ec == std::errc::result_out_of_range)
+        return eCONVERT_RANGE;
+      if (r.ec != std::errc() || r.ptr != digits + n)
+        return eCONVERT_SYNTAX;
+
+      value = negative ? -result : result;
+      return eCONVERT_OK;
+  }
+
+  ConvertError parseCents(std::string_view text, long long &cents)
+  {
+      bool negative;
+      ConvertError error = currencyDigits(text, negative);
+      if (error != eCONVERT_OK)
+        return error;
+
+      const long long LIMIT = (std::numeric_limits<long long>::max() - 9) / 10;
+      long long result = 0;
+      int decimals = -1;
+      bool roundUp = false;
+
+      for (std::size_t i = 0; i < text.size(); i++)
+      {
+        char c = text[i];
+        if (c == ',')
+          continue;
+        if (c == '.')
+        {
+          decimals = 0;
+          continue;
+        }
+        if (decimals >= 2)
+        {
+          // only the first dropped digit decides the rounding
+          if (decimals == 2)
+            roundUp = (c >= '5');
+          decimals++;
+          continue;
+        }
+        if (result > LIMIT)
+          return eCONVERT_RANGE;
+        result = result * 10 + (c - '0');
+        if (decimals >= 0)
+          decimals++;
+      }
+      for (int d = (decimals < 0) ? 0 : decimals; d < 2; d++)
+      {
+        if (result > LIMIT)
+          return eCONVERT_RANGE;
+        result *= 10;
+      }
+      if (roundUp)
+        result++;
+
+      cents = negative ? -result : result;
+      return eCONVERT_OK;
+  }
+
+  double toCurrency(std::string_view text)
+  {
+      double value = 0.0;
+      ConvertError error = parseCurrency(text, value);
+      if (error != eCONVERT_OK)
+        throwConvertError(error, text);
+      return value;
+  }
+
+  long long toCents(std::string_view text)
+  {
+      long long cents = 0;
+      ConvertError error = parseCents(text, cents);
+      if (error != eCONVERT_OK)
+        throwConvertError(error, text);
+      return cents;
+  }
+
+  /*
+  ** DICTIONARY
+  */
+
+  Dictionary::Dictionary(void)
+  {
+      intern(std::string_view());
+  }
+
+  Dictionary::Id Dictionary::intern(std::string_view value)
+  {
+      auto it = _ids.find(value);
+      if (it != _ids.end())
+        return it->second;
+
+      if (_values.size() > std::numeric_limits<Id>::max())
+        throw Error("dictionary is full");
+      Id id = static_cast<Id>(_values.size());
+      _values.push_back(std::string(value));
+      _ids.emplace(std::string_view(_values.back()), id);
+      return id;
+  }
+
+  bool Dictionary::find(std::string_view value, Id &id) const
+  {
+      auto it = _ids.find(value);
+      if (it == _ids.end())
+        return false;
+      id = it->second;
+      return true;
+  }
+
+  const std::string &Dictionary::lookup(Id id) const
+  {
+      if (id >= _values.size())
+        throw Error("can't return this value (doesn't exist)");
+      return _values[id];
+  }
+
+  unsigned int Dictionary::size(void) const
+  {
+      return _values.size();
+  }
+
+  /*
+  ** ARENA
+  */
+
+  Arena::Arena(std::size_t blockSize)
+    : _blockSize(blockSize), _cursor(nullptr), _left(0)
+  {
+  }
+
+  Arena::~Arena(void)
+  {
+      for (auto it = _blocks.begin(); it != _blocks.end(); it++)
+        delete[] *it;
+  }
+
+  void *Arena::allocate(std::size_t size, std::size_t align)
+  {
+      std::size_t pad = (align - reinterpret_cast<std::uintptr_t>(_cursor) % align) % align;
+
+      if (pad + size > _left)
+      {
+        // oversized requests get a block of their own so the current
+        // block keeps its free space
+        if (size + align > _blockSize / 4)
+        {
+          char *block = new char[size + align];
+          _blocks.push_back(block);
+          std::size_t skip = (align - reinterpret_cast<std::uintptr_t>(block) % align) % align;
+          return block + skip;
+        }
+        _cursor = new char[_blockSize];
+        _left = _blockSize;
+        _blocks.push_back(_cursor);
+        pad = (align - reinterpret_cast<std::uintptr_t>(_cursor) % align) % align;
+      }
+
+      char *result = _cursor + pad;
+      _cursor += pad + size;
+      _left -= pad + size;
+      return result;
+  }
+
+  std::size_t Arena::blockCount(void) const
+  {
+      return _blocks.size();
+  }
+
+  /*
+  ** MAPPED FILE
+  */
+
+#ifdef _WIN32
+  MappedFile::MappedFile(const std::string &path, AccessPattern access)
+    : _data(nullptr), _size(0), _fileHandle(INVALID_HANDLE_VALUE), _mapHandle(nullptr)
+  {
+      DWORD hint = access == eRANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+      HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, hint, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        throw Error(std::string("Failed to open ").append(path));
+      _fileHandle = file;
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size))
+      {
+        CloseHandle(file);
+        throw Error(std::string("Failed to open ").append(path));
+      }
+      _size = static_cast<std::size_t>(size.QuadPart);
+      if (_size == 0)
+        return;
+
+      _mapHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (_mapHandle != nullptr)
+        _data = static_cast<const char *>(MapViewOfFile(_mapHandle, FILE_MAP_READ, 0, 0, 0));
+      if (_data == nullptr)
+      {
+        if (_mapHandle != nullptr)
+          CloseHandle(_mapHandle);
+        CloseHandle(file);
+        throw Error(std::string("Failed to map ").append(path));
+      }
+  }
+
+  MappedFile::~MappedFile(void)
+  {
+      if (_data != nullptr)
+        UnmapViewOfFile(_data);
+      if (_mapHandle != nullptr)
+        CloseHandle(_mapHandle);
+      if (_fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(_fileHandle);
+  }
+#else
+  MappedFile::MappedFile(const std::string &path, AccessPattern access)
+    : _data(nullptr), _size(0)
+  {
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw Error(std::string("Failed to open ").append(path));
+
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+      {
+        close(fd);
+        throw Error(std::string("Failed to open ").append(path));
+      }
+      _size = static_cast<std::size_t>(st.st_size);
+
+      if (_size > 0)
+      {
+        void *addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+          close(fd);
+          throw Error(std::string("Failed to map ").append(path));
+        }
+        madvise(addr, _size, access == eRANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+        _data = static_cast<const char *>(addr);
+      }
+      // the mapping stays valid after the descriptor is closed
+      close(fd);
+  }
+
+  MappedFile::~MappedFile(void)
+  {
+      if (_data != nullptr)
+        munmap(const_cast<char *>(_data), _size);
+  }
+#endif
+
+  const char *MappedFile::data(void) const
+  {
+      return _data;
+  }
+
+  std::size_t MappedFile::size(void) const
+  {
+      return _size;
+  }
+
+  /*
+  ** SCHEMA
+  */
+
+  Schema::Schema(const std::vector<std::string> &header, const std::vector<int> &slots)
+    : _header(header), _slots(slots)
+  {
+      _index.reserve(header.size());
+      // emplace keeps the first of any duplicate names, like a linear scan
+      for (std::size_t i = 0; i < header.size(); i++)
+        _index.emplace(header[i], static_cast<unsigned int>(i));
+  }
+
+  const std::vector<std::string> &Schema::header(void) const
+  {
+      return _header;
+  }
+
+  unsigned int Schema::size(void) const
+  {
+      return _header.size();
+  }
+
+  bool Schema::projected(void) const
+  {
+      return !_slots.empty();
+  }
+
+  int Schema::index(const std::string &name) const
+  {
+      auto it = _index.find(name);
+      return (it != _index.end()) ? static_cast<int>(it->second) : -1;
+  }
+
+  int Schema::slot(unsigned int column) const
+  {
+      if (_slots.empty())
+        return (column < _header.size()) ? static_cast<int>(column) : -1;
+      return (column < _slots.size()) ? _slots[column] : -1;
+  }
+
+  /*
+  ** PARSER
+  */
+
   Parser::Parser(const std::string &data, const DataType &type, char sep)
-    : _type(type), _sep(sep)
+    : _type(type), _sep(sep),
+      _journal(false), _compactThreshold(0)
+  {
+      load(data);
+  }
+
+  Parser::Parser(const std::string &data, const std::vector<unsigned int> &columns,
+                 const DataType &type, char sep)
+    : _type(type), _sep(sep), _columns(columns),
+      _journal(false), _compactThreshold(0)
+  {
+      load(data);
+  }
+
+  Parser::Parser(const std::string &data, const std::vector<std::string> &columnNames,
+                 const DataType &type, char sep)
+    : _type(type), _sep(sep), _columnNames(columnNames),
+      _journal(false), _compactThreshold(0)
+  {
+      load(data);
+  }
+
+  void Parser::load(const std::string &data)
   {
       std::string line;
-      if (type == eFILE)
+      if (_type == eARENA)
+      {
+        _file = data;
+        _arena.reset(new Arena());
+
+        // the whole file goes into one arena allocation
+        std::ifstream ifile(_file.c_str(), std::ios::in | std::ios::binary);
+        if (!ifile.is_open())
+          throw Error(std::string("Failed to open ").append(_file));
+        std::error_code ec;
+        std::size_t size = std::filesystem::file_size(_file, ec);
+        if (ec)
+          throw Error(std::string("Failed to open ").append(_file));
+
+        char *buffer = static_cast<char *>(_arena->allocate(size, 1));
+        ifile.read(buffer, size);
+        _text = std::string_view(buffer, static_cast<std::size_t>(ifile.gcount()));
+
+        parseContent();
+        replayJournal();
+      }
+      else if (_type == eMMAP || _type == ePARALLEL)
+      {
+        _file = data;
+        _map.reset(new MappedFile(_file));
+        parseContent();
+        replayJournal();
+      }
+      else if (_type == eFILE)
       {
         _file = data;
         std::ifstream ifile(_file.c_str());
@@ -26,8 +818,8 @@ namespace csv {
             if (_originalFile.size() == 0)
               throw Error(std::string("No Data in ").append(_file));
             
-            parseHeader();
             parseContent();
+            replayJournal();
         }
         else
             throw Error(std::string("Failed to open ").append(_file));
@@ -41,7 +833,6 @@ namespace csv {
         if (_originalFile.size() == 0)
           throw Error(std::string("No Data in pure content"));
 
-        parseHeader();
         parseContent();
       }
   }
@@ -51,52 +842,189 @@ namespace csv {
      std::vector<Row *>::iterator it;
 
      for (it = _content.begin(); it != _content.end(); it++)
-          delete *it;
+          freeRow(*it);
   }
 
-  void Parser::parseHeader(void)
+  void Parser::parseHeader(std::string_view line)
   {
-      std::stringstream ss(_originalFile[0]);
-      std::string item;
+      splitHeader(line, _sep, _header);
 
-      while (std::getline(ss, item, _sep))
-          _header.push_back(item);
+      if (!_columnNames.empty())
+        _columns = columnsByName(_header, _columnNames);
+      if (!_columns.empty())
+        _schema.reset(new Schema(_header, projectionSlots(_header, _columns)));
+      else
+        _schema.reset(new Schema(_header));
   }
 
   void Parser::parseContent(void)
   {
+     FieldScanner scanner(_sep);
+     auto onRecord = [this](std::string_view record, const std::vector<std::string_view> &fields)
+     {
+         if (_header.empty())
+             parseHeader(record);
+         else
+             pushRecord(fields);
+     };
+
+     if (_type == ePARALLEL)
+     {
+        parseParallel();
+        return;
+     }
+
+     if (_type == eMMAP || _type == eARENA)
+     {
+        // tokenize the mapping or arena buffer in place, nothing is copied
+        if (_type == eMMAP)
+          _text = std::string_view(_map->data(), _map->size());
+        scanner.scan(_text.data(), _text.size(), onRecord);
+
+        if (_header.empty())
+          throw Error(std::string("No Data in ").append(_file));
+        return;
+     }
+
      std::vector<std::string>::iterator it;
-     
-     it = _originalFile.begin();
-     it++; // skip header
 
-     for (; it != _originalFile.end(); it++)
+     for (it = _originalFile.begin(); it != _originalFile.end(); it++)
+         scanner.scan(it->data(), it->length(), onRecord);
+  }
+
+  void Parser::parseParallel(void)
+  {
+     const char *data = _map->data();
+     const std::size_t size = _map->size();
+     FieldScanner headerScanner(_sep);
+     std::size_t bodyStart = 0;
+
+     // the header is parsed up front so the chunks only hold data rows
+     while (_header.empty() && bodyStart < size)
      {
-         bool quoted = false;
-         int tokenStart = 0;
-         unsigned int i = 0;
-
-         Row *row = new Row(_header);
-
-         for (; i != it->length(); i++)
-         {
-              if (it->at(i) == '"')
-                  quoted = ((quoted) ? (false) : (true));
-              else if (it->at(i) == ',' && !quoted)
-              {
-                  row->push(it->substr(tokenStart, i - tokenStart));
-                  tokenStart = i + 1;
-              }
-         }
-
-         //end
-         row->push(it->substr(tokenStart, it->length() - tokenStart));
-
-         // if value(s) missing
-         if (row->size() != _header.size())
-          throw Error("corrupted data !");
-         _content.push_back(row);
+        std::size_t end = recordEnd(data, size, bodyStart, false);
+        headerScanner.scan(data + bodyStart, end - bodyStart,
+            [this](std::string_view record, const std::vector<std::string_view> &)
+            {
+                parseHeader(record);
+            });
+        bodyStart = end;
      }
+     if (_header.empty())
+       throw Error(std::string("No Data in ").append(_file));
+
+     // one chunk per core, but no smaller than MIN_CHUNK bytes
+     const std::size_t MIN_CHUNK = 1 << 20;
+     std::size_t body = size - bodyStart;
+     std::size_t chunks = std::max(1u, std::thread::hardware_concurrency());
+     chunks = std::max<std::size_t>(1, std::min(chunks, body / MIN_CHUNK));
+
+     std::vector<std::size_t> bounds(chunks + 1);
+     for (std::size_t i = 0; i <= chunks; i++)
+        bounds[i] = bodyStart + body * i / chunks;
+
+     // count quotes per byte range in parallel; the running parity gives
+     // the quote state at the start of each range
+     std::vector<std::size_t> quotes(chunks);
+     std::vector<std::thread> workers;
+     auto countQuotes = [&](std::size_t i)
+     {
+        quotes[i] = std::count(data + bounds[i], data + bounds[i + 1], '"');
+     };
+     for (std::size_t i = 1; i < chunks; i++)
+        workers.emplace_back(countQuotes, i);
+     countQuotes(0);
+     for (auto &w : workers)
+        w.join();
+     workers.clear();
+
+     // move each inner boundary forward to the next real record end
+     bool quoted = false;
+     for (std::size_t i = 1; i < chunks; i++)
+     {
+        quoted ^= (quotes[i - 1] & 1) != 0;
+        bounds[i] = std::max(bounds[i - 1], recordEnd(data, size, bounds[i], quoted));
+     }
+
+     std::vector<std::vector<Row *> > rows(chunks);
+     std::vector<std::exception_ptr> errors(chunks);
+     auto parseChunk = [&](std::size_t i)
+     {
+        try
+        {
+            FieldScanner scanner(_sep);
+            scanner.scan(data + bounds[i], bounds[i + 1] - bounds[i],
+                [&](std::string_view, const std::vector<std::string_view> &fields)
+                {
+                    rows[i].push_back(makeRow(fields));
+                });
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception();
+        }
+     };
+
+     // the calling thread takes the first chunk itself
+     for (std::size_t i = 1; i < chunks; i++)
+        workers.emplace_back(parseChunk, i);
+     parseChunk(0);
+     for (auto &w : workers)
+        w.join();
+
+     // a failed chunk fails the constructor, so ~Parser won't run to
+     // free the rows the others made
+     for (auto &error : errors)
+        if (error)
+        {
+          for (auto &chunk : rows)
+            for (Row *row : chunk)
+              freeRow(row);
+          std::rethrow_exception(error);
+        }
+
+     // join the chunks back in file order
+     std::size_t total = 0;
+     for (auto &chunk : rows)
+        total += chunk.size();
+     _content.reserve(total);
+     for (auto &chunk : rows)
+        _content.insert(_content.end(), chunk.begin(), chunk.end());
+  }
+
+  Row *Parser::makeRow(const std::vector<std::string_view> &fields) const
+  {
+     // if value(s) missing
+     if (fields.size() != _header.size())
+      throw Error("corrupted data !");
+
+     Row *row = newRow();
+
+     pushFields(*row, fields, *_schema);
+     return row;
+  }
+
+  Row *Parser::newRow(void) const
+  {
+     if (!_arena)
+       return new Row(*_schema);
+
+     void *mem = _arena->allocate(sizeof(Row), alignof(Row));
+     return new (mem) Row(*_schema, _arena.get());
+  }
+
+  void Parser::freeRow(Row *row) const
+  {
+     // arena rows only give back what they own, the arena keeps the rest
+     if (_arena)
+       row->~Row();
+     else
+       delete row;
+  }
+
+  void Parser::pushRecord(const std::vector<std::string_view> &fields)
+  {
+     _content.push_back(makeRow(fields));
   }
 
   Row &Parser::getRow(unsigned int rowPosition) const
@@ -137,8 +1065,11 @@ namespace csv {
   {
     if (pos < _content.size())
     {
-      delete *(_content.begin() + pos);
+      freeRow(*(_content.begin() + pos));
       _content.erase(_content.begin() + pos);
+
+      if (_journal)
+        _pending.append("-").append(std::to_string(pos)).append("\n");
       return true;
     }
     return false;
@@ -146,42 +1077,162 @@ namespace csv {
 
   bool Parser::addRow(unsigned int pos, const std::vector<std::string> &r)
   {
-    Row *row = new Row(_header);
+    if (pos > _content.size())
+      return false;
+
+    Row *row = newRow();
+
+    for (std::size_t i = 0; i < r.size(); i++)
+      if (!_schema->projected() || _schema->slot(i) >= 0)
+        row->push(r[i]);
+    _content.insert(_content.begin() + pos, row);
 
-    for (auto it = r.begin(); it != r.end(); it++)
-      row->push(*it);
-    
-    if (pos <= _content.size())
+    if (_journal)
     {
-      _content.insert(_content.begin() + pos, row);
-      return true;
+      _pending.append("+").append(std::to_string(pos));
+      for (auto it = r.begin(); it != r.end(); it++)
+        _pending.append(1, _sep).append(*it);
+      _pending.append("\n");
     }
-    return false;
+    return true;
+  }
+
+  void Parser::enableJournal(std::size_t compactThreshold)
+  {
+    if (_type == ePURE)
+      throw Error("can't journal pure content");
+    if (_schema->projected())
+      throw Error("can't journal a projected parser");
+
+    _journal = true;
+    _compactThreshold = compactThreshold;
   }
 
-  void Parser::sync(void) const
+  std::string Parser::journalName(void) const
   {
-    if (_type == DataType::eFILE)
+    return _file + ".journal";
+  }
+
+  void Parser::replayJournal(void)
+  {
+    std::ifstream in(journalName().c_str(), std::ios::in | std::ios::binary);
+    if (!in)
+      return;
+
+    std::string log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    FieldScanner scanner(_sep);
+
+    // an op that doesn't apply means the journal was written against
+    // another version of the file, or its last append was cut short
+    auto replay = [this](std::string_view, const std::vector<std::string_view> &fields)
     {
-      std::ofstream f;
-      f.open(_file, std::ios::out | std::ios::trunc);
+        std::string_view op = fields[0];
+        unsigned int pos = 0;
+        bool applied = false;
 
-      // header
-      unsigned int i = 0;
-      for (auto it = _header.begin(); it != _header.end(); it++)
-      {
-        f << *it;
-        if (i < _header.size() - 1)
-          f << ",";
-        else
-          f << std::endl;
-        i++;
-      }
-     
+        if (op.size() < 2 || std::from_chars(op.data() + 1, op.data() + op.size(), pos).ec != std::errc())
+          throw Error(std::string("corrupted journal ").append(journalName()));
+
+        if (op[0] == '-' && fields.size() == 1)
+          applied = deleteRow(pos);
+        else if (op[0] == '+' && fields.size() == _header.size() + 1)
+          applied = addRow(pos, std::vector<std::string>(fields.begin() + 1, fields.end()));
+        if (!applied)
+          throw Error(std::string("corrupted journal ").append(journalName()));
+    };
+
+    // the constructor is what fails, so ~Parser won't free the rows
+    try
+    {
+      scanner.scan(log.data(), log.size(), replay);
+    }
+    catch (...)
+    {
       for (auto it = _content.begin(); it != _content.end(); it++)
-        f << **it << std::endl;
+        freeRow(*it);
+      _content.clear();
+      throw;
+    }
+  }
+
+  void Parser::sync(void)
+  {
+    // a projected parser only holds some of the columns
+    if (_schema->projected())
+      throw Error("can't sync a projected parser");
+    if (_type == DataType::ePURE)
+      return;
+
+    if (!_journal)
+    {
+      compact();
+      return;
+    }
+    if (_pending.empty())
+      return;
+
+    // one append for every change since the last sync
+    std::ofstream f(journalName().c_str(), std::ios::out | std::ios::app | std::ios::binary);
+    f.write(_pending.data(), _pending.size());
+    f.flush();
+    if (!f)
+      throw Error(std::string("Failed to write ").append(journalName()));
+    _pending.clear();
+
+    if (static_cast<std::size_t>(f.tellp()) >= _compactThreshold)
+    {
       f.close();
+      compact();
+    }
+  }
+
+  void Parser::compact(void)
+  {
+    if (_schema->projected())
+      throw Error("can't sync a projected parser");
+    if (_type == DataType::ePURE)
+      return;
+
+    // build the whole file in memory and write it once; no per-line flush
+    std::string out;
+    for (std::size_t i = 0; i < _header.size(); i++)
+    {
+      if (i > 0)
+        out.append(1, _sep);
+      out.append(_header[i]);
     }
+    out.append("\n");
+
+    for (auto it = _content.begin(); it != _content.end(); it++)
+    {
+      for (unsigned int i = 0; i < (*it)->size(); i++)
+      {
+        if (i > 0)
+          out.append(1, _sep);
+        out.append((*it)->view(i));
+      }
+      out.append("\n");
+    }
+
+    // write beside the file and rename over it, so a mapped original
+    // stays valid for rows that still point into it
+    std::string temp = _file + ".tmp";
+    {
+      std::ofstream f(temp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+      f.write(out.data(), out.size());
+      f.flush();
+      if (!f)
+        throw Error(std::string("Failed to write ").append(temp));
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, _file, ec);
+    if (ec)
+      throw Error(std::string("Failed to write ").append(_file));
+
+    // every journaled change is in the file now
+    std::filesystem::remove(journalName(), ec);
+    _pending.clear();
   }
 
   const std::string &Parser::getFileName(void) const
@@ -189,12 +1240,122 @@ namespace csv {
       return _file;    
   }
   
+  /*
+  ** READER
+  */
+
+  Reader::Reader(const std::string &file, char sep)
+    : _file(new std::ifstream(file.c_str(), std::ios::in | std::ios::binary)),
+      _in(*_file), _sep(sep), _buffer(BUFFER_SIZE), _begin(0), _end(0), _eof(false)
+  {
+      if (!*_file)
+        throw Error(std::string("Failed to open ").append(file));
+      if (std::filesystem::exists(file + ".journal"))
+        throw Error(std::string("Unapplied journal for ").append(file).append(", compact it first"));
+      readHeader();
+  }
+
+  Reader::Reader(std::istream &in, char sep)
+    : _in(in), _sep(sep), _buffer(BUFFER_SIZE), _begin(0), _end(0), _eof(false)
+  {
+      readHeader();
+  }
+
+  Reader::~Reader(void) {}
+
+  const std::vector<std::string> &Reader::getHeader(void) const
+  {
+      return _header;
+  }
+
+  void Reader::project(const std::vector<unsigned int> &columns)
+  {
+      _schema.reset(new Schema(_header, projectionSlots(_header, columns)));
+  }
+
+  void Reader::project(const std::vector<std::string> &columnNames)
+  {
+      _schema.reset(new Schema(_header, projectionSlots(_header, columnsByName(_header, columnNames))));
+  }
+
+  void Reader::fill(void)
+  {
+      // keep the unfinished record, growing the buffer if it fills it
+      if (_begin > 0)
+      {
+        std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+      }
+      if (_end == _buffer.size())
+        _buffer.resize(_buffer.size() * 2);
+
+      _in.read(_buffer.data() + _end, _buffer.size() - _end);
+      _end += static_cast<std::size_t>(_in.gcount());
+      if (!_in)
+        _eof = true;
+  }
+
+  void Reader::readHeader(void)
+  {
+      while (_header.empty())
+      {
+        std::size_t end = recordEnd(_buffer.data(), _end, _begin, false);
+        if (end == _end && !_eof)
+        {
+          fill();
+          continue;
+        }
+
+        std::string_view line(_buffer.data() + _begin, end - _begin);
+        if (!line.empty() && line.back() == '\n')
+          line.remove_suffix(1);
+        if (!line.empty() && line.back() == '\r')
+          line.remove_suffix(1);
+        if (!line.empty())
+        {
+          splitHeader(line, _sep, _header);
+          _schema.reset(new Schema(_header));
+        }
+        _begin = end;
+
+        if (_header.empty() && _eof && _begin == _end)
+          throw Error(std::string("No Data in stream"));
+      }
+  }
+
+  void Reader::forEachRow(const std::function<void(const Row &)> &func)
+  {
+      FieldScanner scanner(_sep);
+      Row row(*_schema);
+
+      for (;;)
+      {
+        _begin += scanner.scan(_buffer.data() + _begin, _end - _begin,
+            [&](std::string_view, const std::vector<std::string_view> &fields)
+            {
+                // if value(s) missing
+                if (fields.size() != _header.size())
+                  throw Error("corrupted data !");
+
+                row._values.clear();
+                row._owned.clear();
+                pushFields(row, fields, *_schema);
+                func(row);
+            }, _eof);
+
+        if (_eof)
+          break;
+        fill();
+      }
+  }
+
   /*
   ** ROW
   */
 
-  Row::Row(const std::vector<std::string> &header)
-      : _header(header) {}
+  Row::Row(const Schema &schema, Arena *arena)
+      : _schema(schema), _values(ArenaAllocator<std::string_view>(arena)) {}
 
   Row::~Row(void) {}
 
@@ -203,47 +1364,63 @@ namespace csv {
     return _values.size();
   }
 
+  int Row::slot(unsigned int pos) const
+  {
+    int s = _schema.slot(pos);
+
+    return (s >= 0 && static_cast<unsigned int>(s) < _values.size()) ? s : -1;
+  }
+
   void Row::push(const std::string &value)
+  {
+    _owned.push_back(value);
+    _values.push_back(_owned.back());
+  }
+
+  void Row::pushView(std::string_view value)
   {
     _values.push_back(value);
   }
 
+  void Row::reserve(unsigned int count)
+  {
+    _values.reserve(count);
+  }
+
   bool Row::set(const std::string &key, const std::string &value) 
   {
-    std::vector<std::string>::const_iterator it;
-    int pos = 0;
+    int pos = _schema.index(key);
+    int s = (pos >= 0) ? slot(pos) : -1;
 
-    for (it = _header.begin(); it != _header.end(); it++)
-    {
-        if (key == *it)
-        {
-          _values[pos] = value;
-          return true;
-        }
-        pos++;
-    }
-    return false;
+    if (s < 0)
+      return false;
+    _owned.push_back(value);
+    _values[s] = _owned.back();
+    return true;
   }
 
   const std::string Row::operator[](unsigned int valuePosition) const
   {
-       if (valuePosition < _values.size())
-           return _values[valuePosition];
+       int s = slot(valuePosition);
+       if (s >= 0)
+           return std::string(_values[s]);
+       throw Error("can't return this value (doesn't exist)");
+  }
+
+  std::string_view Row::view(unsigned int valuePosition) const
+  {
+       int s = slot(valuePosition);
+       if (s >= 0)
+           return _values[s];
        throw Error("can't return this value (doesn't exist)");
   }
 
   const std::string Row::operator[](const std::string &key) const
   {
-      std::vector<std::string>::const_iterator it;
-      int pos = 0;
+      int pos = _schema.index(key);
 
-      for (it = _header.begin(); it != _header.end(); it++)
-      {
-          if (key == *it)
-              return _values[pos];
-          pos++;
-      }
-      
+      if (pos >= 0)
+          return (*this)[pos];
       throw Error("can't return this value (doesn't exist)");
   }
 
@@ -265,4 +1442,180 @@ namespace csv {
     }
     return os;
   }
+
+  /*
+  ** SNAPSHOT
+  */
+
+  namespace {
+
+    const char SNAPSHOT_MAGIC[8] = { 'C', 'S', 'V', 'S', 'N', 'A', 'P', '\0' };
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t textColumns;
+        std::uint32_t numberColumns;
+        std::uint32_t reserved;
+        std::uint64_t rows;
+        std::uint64_t sourceSize;
+        std::int64_t sourceTime;
+        std::uint64_t heapSize;
+        std::uint64_t checksum;
+    };
+
+    // 64-bit FNV-1a over the payload following the header
+    std::uint64_t checksum(const char *data, std::size_t size, std::uint64_t hash = 14695981039346656037ULL)
+    {
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    void sourceStamp(const std::string &source, std::uint64_t &size, std::int64_t &time)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(source, ec);
+        if (ec)
+          throw Error(std::string("Failed to open ").append(source));
+        time = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+        if (ec)
+          throw Error(std::string("Failed to open ").append(source));
+    }
+  }
+
+  SnapshotWriter::SnapshotWriter(unsigned int textColumns, unsigned int numberColumns)
+    : _textColumns(textColumns), _numberColumns(numberColumns), _offsets(1, 0)
+  {
+  }
+
+  void SnapshotWriter::add(const std::vector<std::string_view> &text, const std::vector<double> &numbers)
+  {
+      if (text.size() != _textColumns || numbers.size() != _numberColumns)
+        throw Error("snapshot row doesn't match its columns");
+
+      for (auto it = text.begin(); it != text.end(); it++)
+      {
+        _heap.append(it->data(), it->size());
+        _offsets.push_back(_heap.size());
+      }
+      _numbers.insert(_numbers.end(), numbers.begin(), numbers.end());
+  }
+
+  void SnapshotWriter::write(const std::string &path, const std::string &source) const
+  {
+      SnapshotHeader header;
+      std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+      header.version = Snapshot::VERSION;
+      header.textColumns = _textColumns;
+      header.numberColumns = _numberColumns;
+      header.reserved = 0;
+      header.rows = (_textColumns > 0) ? (_offsets.size() - 1) / _textColumns
+                                       : _numbers.size() / std::max(1u, _numberColumns);
+      sourceStamp(source, header.sourceSize, header.sourceTime);
+      header.heapSize = _heap.size();
+
+      const char *offsets = reinterpret_cast<const char *>(_offsets.data());
+      const char *numbers = reinterpret_cast<const char *>(_numbers.data());
+      std::size_t offsetsSize = _offsets.size() * sizeof(std::uint64_t);
+      std::size_t numbersSize = _numbers.size() * sizeof(double);
+
+      header.checksum = checksum(offsets, offsetsSize);
+      header.checksum = checksum(numbers, numbersSize, header.checksum);
+      header.checksum = checksum(_heap.data(), _heap.size(), header.checksum);
+
+      std::string temp = path + ".tmp";
+      {
+        std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+          throw Error(std::string("Failed to open ").append(temp));
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(offsets, offsetsSize);
+        out.write(numbers, numbersSize);
+        out.write(_heap.data(), _heap.size());
+        if (!out.flush())
+          throw Error(std::string("Failed to write ").append(temp));
+      }
+
+      std::error_code ec;
+      std::filesystem::rename(temp, path, ec);
+      if (ec)
+      {
+        std::filesystem::remove(temp, ec);
+        throw Error(std::string("Failed to write ").append(path));
+      }
+  }
+
+  Snapshot::Snapshot(const std::string &path, const std::string &source)
+    : _map(path), _rows(0), _textColumns(0), _numberColumns(0),
+      _offsets(nullptr), _numbers(nullptr), _heap(nullptr)
+  {
+      if (_map.size() < sizeof(SnapshotHeader))
+        throw Error(std::string("Snapshot too short : ").append(path));
+
+      SnapshotHeader header;
+      std::memcpy(&header, _map.data(), sizeof(header));
+      if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+        throw Error(std::string("Not a snapshot : ").append(path));
+      if (header.version != VERSION)
+        throw Error(std::string("Snapshot version mismatch : ").append(path));
+
+      std::uint64_t sourceSize;
+      std::int64_t sourceTime;
+      sourceStamp(source, sourceSize, sourceTime);
+      if (header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+        throw Error(std::string("Snapshot is stale : ").append(path));
+
+      // journaled changes aren't in the CSV the snapshot was built from
+      if (std::filesystem::exists(source + ".journal"))
+        throw Error(std::string("Snapshot is stale : ").append(path));
+
+      std::uint64_t fields = header.rows * header.textColumns;
+      std::uint64_t offsetsSize = (fields + 1) * sizeof(std::uint64_t);
+      std::uint64_t numbersSize = header.rows * header.numberColumns * sizeof(double);
+      if (_map.size() != sizeof(header) + offsetsSize + numbersSize + header.heapSize)
+        throw Error(std::string("Snapshot is corrupted : ").append(path));
+
+      const char *payload = _map.data() + sizeof(header);
+      if (checksum(payload, _map.size() - sizeof(header)) != header.checksum)
+        throw Error(std::string("Snapshot checksum mismatch : ").append(path));
+
+      _rows = static_cast<unsigned int>(header.rows);
+      _textColumns = header.textColumns;
+      _numberColumns = header.numberColumns;
+      _offsets = reinterpret_cast<const std::uint64_t *>(payload);
+      _numbers = reinterpret_cast<const double *>(payload + offsetsSize);
+      _heap = payload + offsetsSize + numbersSize;
+
+      // offsets must climb and stay inside the heap
+      for (std::uint64_t i = 0; i < fields; i++)
+        if (_offsets[i] > _offsets[i + 1])
+          throw Error(std::string("Snapshot is corrupted : ").append(path));
+      if (_offsets[0] != 0 || _offsets[fields] != header.heapSize)
+        throw Error(std::string("Snapshot is corrupted : ").append(path));
+  }
+
+  unsigned int Snapshot::rowCount(void) const
+  {
+      return _rows;
+  }
+
+  std::string_view Snapshot::text(unsigned int row, unsigned int column) const
+  {
+      if (row >= _rows || column >= _textColumns)
+        throw Error("can't return this value (doesn't exist)");
+      std::size_t k = static_cast<std::size_t>(row) * _textColumns + column;
+      return std::string_view(_heap + _offsets[k], _offsets[k + 1] - _offsets[k]);
+  }
+
+  double Snapshot::number(unsigned int row, unsigned int column) const
+  {
+      if (row >= _rows || column >= _numberColumns)
+        throw Error("can't return this value (doesn't exist)");
+      return _numbers[static_cast<std::size_t>(row) * _numberColumns + column];
+  }
 }
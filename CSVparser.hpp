@@ -2,9 +2,21 @@
 # define    _CSVPARSER_HPP_
 
 # include <stdexcept>
+# include <charconv>
+# include <type_traits>
 # include <string>
+# include <string_view>
+# include <cstdint>
 # include <vector>
 # include <list>
+# include <array>
+# include <tuple>
+# include <utility>
+# include <deque>
+# include <unordered_map>
+# include <memory>
+# include <functional>
+# include <istream>
 # include <sstream>
 
 namespace csv
@@ -19,53 +31,470 @@ namespace csv
         }
     };
 
+    /*
+    ** Field conversion straight from the text with std::from_chars,
+    ** without building a stream or a temporary string.
+    */
+    enum ConvertError {
+        eCONVERT_OK = 0,
+        eCONVERT_EMPTY = 1,
+        eCONVERT_SYNTAX = 2,
+        eCONVERT_RANGE = 3
+    };
+
+    const char *convertErrorString(ConvertError);
+
+    // Amounts such as "$1,234.50", with optional surrounding quotes,
+    // spaces and sign. The result is left untouched on failure.
+    ConvertError parseCurrency(std::string_view, double &);
+    // Same syntax, as exact whole cents; fractions of a cent round half
+    // away from zero.
+    ConvertError parseCents(std::string_view, long long &);
+
+    // throwing versions, the message names the offending text
+    double toCurrency(std::string_view);
+    long long toCents(std::string_view);
+
+    void throwConvertError(ConvertError, std::string_view);
+
+    template<typename T>
+    T convert(std::string_view text)
+    {
+        if constexpr (std::is_same<T, std::string>::value)
+            return std::string(text);
+        else if constexpr (std::is_floating_point<T>::value
+                           || (std::is_integral<T>::value && sizeof(T) > 1 && !std::is_same<T, bool>::value))
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+                text.remove_prefix(1);
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+                text.remove_suffix(1);
+            if (!text.empty() && text.front() == '+')
+                text.remove_prefix(1);
+            if (text.empty())
+                throwConvertError(eCONVERT_EMPTY, text);
+
+            T res{};
+            std::from_chars_result r = std::from_chars(text.data(), text.data() + text.size(), res);
+            if (r.ec == std::errc::result_out_of_range)
+                throwConvertError(eCONVERT_RANGE, text);
+            if (r.ec != std::errc() || r.ptr != text.data() + text.size())
+                throwConvertError(eCONVERT_SYNTAX, text);
+            return res;
+        }
+        else
+        {
+            // anything from_chars can't read still goes through a stream
+            T res;
+            std::stringstream ss;
+            ss << text;
+            ss >> res;
+            return res;
+        }
+    }
+
+    /*
+    ** Interns the values of a low-cardinality column. Each distinct
+    ** string is stored once and rows carry its small integer id, so
+    ** comparing two values is an integer compare. Id 0 is "".
+    */
+    class Dictionary
+    {
+      public:
+        typedef std::uint32_t Id;
+
+        Dictionary(void);
+        Dictionary(const Dictionary &) = delete;
+        Dictionary &operator=(const Dictionary &) = delete;
+
+      public:
+        Id intern(std::string_view);
+        bool find(std::string_view, Id &) const;
+        const std::string &lookup(Id) const;
+        unsigned int size(void) const;
+
+      private:
+        // a deque never moves its elements, so the map's keys can view them
+        std::deque<std::string> _values;
+        std::unordered_map<std::string_view, Id> _ids;
+    };
+
+    // How a MappedFile will be read; passed on to the OS as a paging hint
+    enum AccessPattern {
+        eSEQUENTIAL = 0,
+        eRANDOM = 1
+    };
+
+    /*
+    ** Read-only view of a whole file, mapped into memory when the
+    ** platform allows it. Rows parsed in eMMAP and ePARALLEL mode
+    ** point into it.
+    */
+    class MappedFile
+    {
+      public:
+        MappedFile(const std::string &, AccessPattern access = eSEQUENTIAL);
+        ~MappedFile(void);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+      public:
+        const char *data(void) const;
+        std::size_t size(void) const;
+
+      private:
+        const char *_data;
+        std::size_t _size;
+# ifdef _WIN32
+        void *_fileHandle;
+        void *_mapHandle;
+# endif
+    };
+
+    /*
+    ** Column names and projection shared by every row of one parser.
+    ** Built once from the header and never changed afterwards.
+    */
+    class Schema
+    {
+      public:
+        Schema(const std::vector<std::string> &, const std::vector<int> &slots = std::vector<int>());
+
+      public:
+        const std::vector<std::string> &header(void) const;
+        unsigned int size(void) const;
+        bool projected(void) const;
+        // column position of a name, or -1
+        int index(const std::string &) const;
+        // where a column's value is stored in a row, or -1 if skipped
+        int slot(unsigned int) const;
+
+      private:
+        const std::vector<std::string> _header;
+        std::unordered_map<std::string, unsigned int> _index;
+        // column -> index in a row's values when projected
+        const std::vector<int> _slots;
+    };
+
+    /*
+    ** Bump allocator handing out memory from large blocks. Nothing is
+    ** freed individually; every block is released with the arena.
+    */
+    class Arena
+    {
+      public:
+        Arena(std::size_t blockSize = 1 << 20);
+        ~Arena(void);
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+      public:
+        void *allocate(std::size_t size, std::size_t align);
+        std::size_t blockCount(void) const;
+
+      private:
+        const std::size_t _blockSize;
+        std::vector<char *> _blocks;
+        char *_cursor;
+        std::size_t _left;
+    };
+
+    // uses the arena when given one, the heap otherwise
+    template<typename T>
+    class ArenaAllocator
+    {
+      public:
+        typedef T value_type;
+
+        ArenaAllocator(Arena *arena = nullptr) : _arena(arena) {}
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other.arena()) {}
+
+        T *allocate(std::size_t n)
+        {
+            if (_arena != nullptr)
+                return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, std::size_t)
+        {
+            if (_arena == nullptr)
+                ::operator delete(p);
+        }
+
+        Arena *arena(void) const { return _arena; }
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U> &other) const { return _arena == other.arena(); }
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U> &other) const { return _arena != other.arena(); }
+
+      private:
+        Arena *_arena;
+    };
+
     class Row
     {
     	public:
-    	    Row(const std::vector<std::string> &);
+    	    Row(const Schema &, Arena *arena = nullptr);
     	    ~Row(void);
+    	    Row(const Row &) = delete;
+    	    Row &operator=(const Row &) = delete;
 
     	public:
             unsigned int size(void) const;
             void push(const std::string &);
+            void pushView(std::string_view);
+            void reserve(unsigned int);
             bool set(const std::string &, const std::string &); 
+            std::string_view view(unsigned int) const;
+
+    	private:
+    		int slot(unsigned int) const;
 
     	private:
-    		const std::vector<std::string> _header;
-    		std::vector<std::string> _values;
+    		const Schema &_schema;
+    		// fields point into the parser's buffer, or into _owned
+    		// for values added through push() and set()
+    		std::vector<std::string_view, ArenaAllocator<std::string_view> > _values;
+    		std::list<std::string> _owned;
 
         public:
 
             template<typename T>
             const T getValue(unsigned int pos) const
             {
-                if (pos < _values.size())
-                {
-                    T res;
-                    std::stringstream ss;
-                    ss << _values[pos];
-                    ss >> res;
-                    return res;
-                }
+                int s = slot(pos);
+                if (s >= 0)
+                    return convert<T>(_values[s]);
                 throw Error("can't return this value (doesn't exist)");
             }
             const std::string operator[](unsigned int) const;
             const std::string operator[](const std::string &valueName) const;
             friend std::ostream& operator<<(std::ostream& os, const Row &row);
             friend std::ofstream& operator<<(std::ofstream& os, const Row &row);
+            friend class Reader;
+    };
+
+    /*
+    ** Compile-time binding of CSV columns to struct fields. Each bind()
+    ** names a column (by header name or index), a member pointer and a
+    ** converter. makeBinder() resolves the columns against the header
+    ** once, so fill() only reads field views and converts them in place.
+    */
+    struct AsString
+    {
+        void operator()(std::string_view text, std::string &out) const
+        {
+            out.assign(text.data(), text.size());
+        }
+    };
+
+    struct AsCurrency
+    {
+        // malformed amounts leave the member as it was
+        void operator()(std::string_view text, double &out) const
+        {
+            parseCurrency(text, out);
+        }
+    };
+
+    struct AsCents
+    {
+        void operator()(std::string_view text, long long &out) const
+        {
+            parseCents(text, out);
+        }
+    };
+
+    struct AsNumber
+    {
+        template<typename N>
+        void operator()(std::string_view text, N &out) const
+        {
+            out = convert<N>(text);
+        }
+    };
+
+    struct AsInterned
+    {
+        AsInterned(Dictionary &dictionary) : _dictionary(&dictionary) {}
+
+        void operator()(std::string_view text, Dictionary::Id &out) const
+        {
+            out = _dictionary->intern(text);
+        }
+
+      private:
+        Dictionary *_dictionary;
+    };
+
+    template<typename T, typename M, typename Convert>
+    struct Binding
+    {
+        typedef T Object;
+
+        std::string name;
+        unsigned int column;
+        M T::*member;
+        Convert convert;
+    };
+
+    template<typename T, typename M, typename Convert>
+    Binding<T, M, Convert> bind(const std::string &name, M T::*member, Convert convert)
+    {
+        return Binding<T, M, Convert>{ name, 0, member, convert };
+    }
+
+    template<typename T, typename M, typename Convert>
+    Binding<T, M, Convert> bind(unsigned int column, M T::*member, Convert convert)
+    {
+        return Binding<T, M, Convert>{ std::string(), column, member, convert };
+    }
+
+    template<typename First, typename... Rest>
+    class Binder
+    {
+      public:
+        typedef typename First::Object Object;
+
+        Binder(const std::vector<std::string> &header, First first, Rest... rest)
+          : _bindings(first, rest...)
+        {
+            resolve(header, std::index_sequence_for<First, Rest...>());
+        }
+
+        // the source columns, to project a parser or reader on
+        std::vector<unsigned int> columns(void) const
+        {
+            return std::vector<unsigned int>(_columns.begin(), _columns.end());
+        }
+
+        void fill(const Row &row, Object &out) const
+        {
+            fillAll(row, out, std::index_sequence_for<First, Rest...>());
+        }
+
+      private:
+        template<std::size_t... I>
+        void resolve(const std::vector<std::string> &header, std::index_sequence<I...>)
+        {
+            ((_columns[I] = column(header, std::get<I>(_bindings).name,
+                                   std::get<I>(_bindings).column)), ...);
+        }
+
+        static unsigned int column(const std::vector<std::string> &header,
+                                   const std::string &name, unsigned int index)
+        {
+            if (!name.empty())
+            {
+                for (std::size_t i = 0; i < header.size(); i++)
+                    if (header[i] == name)
+                        return static_cast<unsigned int>(i);
+                throw Error(std::string("can't bind this column (doesn't exist) : ").append(name));
+            }
+            if (index >= header.size())
+                throw Error("can't bind this column (doesn't exist)");
+            return index;
+        }
+
+        template<std::size_t... I>
+        void fillAll(const Row &row, Object &out, std::index_sequence<I...>) const
+        {
+            (std::get<I>(_bindings).convert(row.view(_columns[I]), out.*(std::get<I>(_bindings).member)), ...);
+        }
+
+      private:
+        std::tuple<First, Rest...> _bindings;
+        std::array<unsigned int, 1 + sizeof...(Rest)> _columns;
+    };
+
+    template<typename First, typename... Rest>
+    Binder<First, Rest...> makeBinder(const std::vector<std::string> &header, First first, Rest... rest)
+    {
+        return Binder<First, Rest...>(header, first, rest...);
+    }
+
+    /*
+    ** Forward-only reader that parses a file or stream one buffered block
+    ** at a time. Rows handed to forEachRow are only valid during the
+    ** call, so memory stays bounded by the largest record. It can't
+    ** replay a Parser journal, so it refuses a file that has one until
+    ** the journal is compacted into it.
+    */
+    class Reader
+    {
+      public:
+        Reader(const std::string &, char sep = ',');
+        Reader(std::istream &, char sep = ',');
+        ~Reader(void);
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+      public:
+        const std::vector<std::string> &getHeader(void) const;
+        void project(const std::vector<unsigned int> &);
+        void project(const std::vector<std::string> &);
+        void forEachRow(const std::function<void(const Row &)> &);
+
+      private:
+        void fill(void);
+        void readHeader(void);
+
+      private:
+        static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+        std::unique_ptr<std::istream> _file;
+        std::istream &_in;
+        const char _sep;
+        std::vector<std::string> _header;
+        std::unique_ptr<Schema> _schema;
+        std::vector<char> _buffer;
+        std::size_t _begin;
+        std::size_t _end;
+        bool _eof;
     };
 
+    // eMMAP maps the file and keeps fields as views into it; ePARALLEL
+    // does the same but parses quote-aligned chunks on all cores; eARENA
+    // reads the file into an arena and places rows and their field
+    // tables there too, all released at once with the parser
     enum DataType {
         eFILE = 0,
-        ePURE = 1
+        ePURE = 1,
+        eMMAP = 2,
+        ePARALLEL = 3,
+        eARENA = 4
     };
 
+    enum ScanMode {
+        eSCAN_AUTO = 0,
+        eSCAN_SCALAR = 1,
+        eSCAN_SSE2 = 2,
+        eSCAN_AVX2 = 3
+    };
+
+    // Selects how every Parser finds delimiters. eSCAN_AUTO (the default)
+    // picks the widest instruction set the CPU supports at runtime.
+    // Returns false if the mode is not available on this machine.
+    bool setScanMode(ScanMode);
+    ScanMode scanMode(void);
+
     class Parser
     {
 
     public:
         Parser(const std::string &, const DataType &type = eFILE, char sep = ',');
+        // keep only the given columns; rows are still indexed by their
+        // original column positions and the rest are never stored
+        Parser(const std::string &, const std::vector<unsigned int> &,
+               const DataType &type = eFILE, char sep = ',');
+        Parser(const std::string &, const std::vector<std::string> &,
+               const DataType &type = eFILE, char sep = ',');
         ~Parser(void);
+        Parser(const Parser &) = delete;
+        Parser &operator=(const Parser &) = delete;
 
     public:
         Row &getRow(unsigned int row) const;
@@ -78,23 +507,100 @@ namespace csv
     public:
         bool deleteRow(unsigned int row);
         bool addRow(unsigned int pos, const std::vector<std::string> &);
-        void sync(void) const;
+        // Without a journal, sync() rewrites the file in a single write.
+        // With one, addRow/deleteRow are logged to <file>.journal, sync()
+        // appends the pending entries in one write, and the file is only
+        // rewritten by compact() or once the journal passes the threshold.
+        // A journal left by an earlier run is replayed on load.
+        void sync(void);
+        void enableJournal(std::size_t compactThreshold = 4 << 20);
+        void compact(void);
 
     protected:
-    	void parseHeader(void);
+    	void load(const std::string &);
+    	void parseHeader(std::string_view);
     	void parseContent(void);
+    	void parseParallel(void);
+    	void pushRecord(const std::vector<std::string_view> &);
+    	Row *makeRow(const std::vector<std::string_view> &) const;
+    	Row *newRow(void) const;
+    	void freeRow(Row *) const;
+    	std::string journalName(void) const;
+    	void replayJournal(void);
 
     private:
         std::string _file;
         const DataType _type;
         const char _sep;
         std::vector<std::string> _originalFile;
+        // the text eMMAP and eARENA rows point into
+        std::string_view _text;
+        std::unique_ptr<MappedFile> _map;
+        std::unique_ptr<Arena> _arena;
         std::vector<std::string> _header;
+        std::vector<unsigned int> _columns;
+        std::vector<std::string> _columnNames;
+        std::unique_ptr<Schema> _schema;
         std::vector<Row *> _content;
+        bool _journal;
+        std::size_t _compactThreshold;
+        std::string _pending;
 
     public:
         Row &operator[](unsigned int row) const;
     };
+
+    /*
+    ** Binary snapshot of rows already pulled out of a CSV file: a header,
+    ** a (offset, length) table for the text fields, the numeric fields as
+    ** doubles, then one string heap. It is memory-mapped back so a reload
+    ** does no text parsing. The header carries a version, a checksum and
+    ** the size and write time of the CSV it was built from; Snapshot
+    ** throws Error when any of them don't match, or the CSV has a Parser
+    ** journal, so callers can fall back to the CSV. Numbers are stored in
+    ** the host's byte order.
+    */
+    class SnapshotWriter
+    {
+      public:
+        SnapshotWriter(unsigned int textColumns, unsigned int numberColumns);
+
+      public:
+        void add(const std::vector<std::string_view> &, const std::vector<double> &);
+        // writes through a temporary file so readers never see half a file
+        void write(const std::string &path, const std::string &source) const;
+
+      private:
+        const unsigned int _textColumns;
+        const unsigned int _numberColumns;
+        std::vector<std::uint64_t> _offsets;
+        std::vector<double> _numbers;
+        std::string _heap;
+    };
+
+    class Snapshot
+    {
+      public:
+        Snapshot(const std::string &path, const std::string &source);
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+      public:
+        static const std::uint32_t VERSION = 1;
+
+        unsigned int rowCount(void) const;
+        std::string_view text(unsigned int row, unsigned int column) const;
+        double number(unsigned int row, unsigned int column) const;
+
+      private:
+        MappedFile _map;
+        unsigned int _rows;
+        unsigned int _textColumns;
+        unsigned int _numberColumns;
+        const std::uint64_t *_offsets;
+        const double *_numbers;
+        const char *_heap;
+    };
 }
 
 #endif /*!_CSVPARSER_HPP_*/
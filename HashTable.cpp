@@ -7,318 +7,1907 @@
 //============================================================================
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 #include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string> // atoi
+#include <thread>
 #include <time.h>
+#include <vector>
 
 #include "CSVparser.hpp"
+#include "HashTable.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define HASHTABLE_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
 
 using namespace std;
 
 //============================================================================
-// Global definitions visible to all methods and classes
+// Global definitions visible to all methods and classes
+//============================================================================
+
+const unsigned int DEFAULT_SIZE = 179;
+
+// threads that can read a ConcurrentHashTable at the same time
+const unsigned int MAX_READERS = 128;
+
+// mutexes shared out among a ConcurrentHashTable's buckets
+const unsigned int LOCK_STRIPES = 64;
+
+// nodes a ConcurrentHashTable retires between attempts to free them
+const unsigned int RECLAIM_INTERVAL = 64;
+
+// fund names shared by every bid; a bid only stores its fund's id
+csv::Dictionary funds;
+
+// define a structure to hold bid information
+struct Bid {
+    string bidId; // unique identifier
+    string title;
+    csv::Dictionary::Id fundId; // index into funds
+    double amount;
+    Bid() {
+        fundId = 0;
+        amount = 0.0;
+    }
+};
+
+/**
+ * Print a bid the way the tables list it
+ */
+ostream& operator<<(ostream& out, const Bid& bid) {
+    return out << bid.bidId << "| " << bid.title << " | " << bid.amount << " | " << funds.lookup(bid.fundId);
+}
+
+/**
+ * The table's original hash, the id's atoi value. Kept to
+ * compare against: every id that isn't a number lands in
+ * bucket 0, and sequential ids only spread while they're
+ * fewer than the buckets.
+ */
+struct AtoiHash {
+    uint64_t operator()(const string& key) const {
+        return (unsigned int) atoi(key.c_str());
+    }
+};
+
+// the bids, keyed by bid id
+typedef HashTable<string, Bid, IntegerHash> BidTable;
+
+
+//============================================================================
+// Flat Hash Table class definition
+//============================================================================
+
+/**
+ * Return the position of the lowest set bit in a non-zero mask
+ */
+inline unsigned int lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long pos;
+    _BitScanForward(&pos, mask);
+    return pos;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement a hash table with open addressing.
+ *
+ * Each slot has a one byte control tag: EMPTY, DELETED, or the low
+ * 7 bits of the key's hash. Tags are probed a group of GROUP_SIZE at
+ * a time with one SIMD compare, so most misses never read a key. The
+ * keys sit in one dense array beside the tags and the bids are kept
+ * out of line, so a probe never walks over bid payloads.
+ */
+class FlatHashTable {
+
+private:
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+    static constexpr unsigned int GROUP_SIZE = 16;
+
+    vector<int8_t> control;        // one tag per slot
+    vector<string> keys;           // bid id of each full slot
+    vector<unsigned int> refs;     // index into bids of each full slot
+    vector<Bid> bids;              // bid payloads, never moved by a rehash
+    vector<unsigned int> freeBids; // entries of bids released by Remove
+
+    unsigned int groupMask = 0;  // number of groups - 1
+    unsigned int count = 0;      // full slots
+    unsigned int tombstones = 0; // deleted slots
+
+    uint64_t hash(const string& key) const;
+    uint32_t match(unsigned int group, int8_t tag) const;
+    uint32_t matchFree(unsigned int group) const;
+    int find(const string& bidId, uint64_t hash) const;
+    unsigned int findFree(uint64_t hash) const;
+    void rehash(unsigned int groups);
+
+public:
+    FlatHashTable();
+    FlatHashTable(unsigned int size);
+    void Insert(Bid bid);
+    void PrintAll();
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    double LoadFactor();
+};
+
+/**
+ * Default constructor
+ */
+FlatHashTable::FlatHashTable() : FlatHashTable(DEFAULT_SIZE) {
+}
+
+/**
+ * Constructor for specifying size of the table
+ * The slot count is rounded up to a power of two
+ * number of groups.
+ */
+FlatHashTable::FlatHashTable(unsigned int size) {
+    unsigned int groups = 1;
+    while (groups * GROUP_SIZE < size) {
+        groups *= 2;
+    }
+    rehash(groups);
+}
+
+/**
+ * Calculate the hash value of a given key.
+ * StringHash mixes every bit of the key into both ends of
+ * the value: the tag is taken from the low 7 bits and the
+ * group from the bits above them.
+ *
+ * @param key The key to hash
+ * @return The calculated hash
+ */
+uint64_t FlatHashTable::hash(const string& key) const {
+    return StringHash()(key);
+}
+
+/**
+ * Compare every tag of a group at once
+ *
+ * @param group The group to probe
+ * @param tag The control byte to look for
+ * @return A mask with bit i set if slot i of the group holds tag
+ */
+uint32_t FlatHashTable::match(unsigned int group, int8_t tag) const {
+    const int8_t* tags = &control[group * GROUP_SIZE];
+#ifdef HASHTABLE_SSE2
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; i++) {
+        if (tags[i] == tag) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Find the EMPTY and DELETED slots of a group, which are the
+ * tags with their top bit set
+ *
+ * @param group The group to probe
+ * @return A mask with bit i set if slot i of the group is free
+ */
+uint32_t FlatHashTable::matchFree(unsigned int group) const {
+    const int8_t* tags = &control[group * GROUP_SIZE];
+#ifdef HASHTABLE_SSE2
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tags)));
+#else
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; i++) {
+        if (tags[i] < 0) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Find the slot holding a bid id. Groups are visited in
+ * triangular order, which reaches every group of a power of
+ * two table; a group with an EMPTY slot ends the probe.
+ *
+ * @param bidId The bid id to search for
+ * @param hash The hash of bidId
+ * @return The slot, or -1 if bidId is not in the table
+ */
+int FlatHashTable::find(const string& bidId, uint64_t hash) const {
+    int8_t tag = hash & 0x7F;
+    unsigned int group = (hash >> 7) & groupMask;
+
+    for (unsigned int step = 1; step <= groupMask + 1; step++) {
+        for (uint32_t mask = match(group, tag); mask != 0; mask &= mask - 1) {
+            unsigned int slot = group * GROUP_SIZE + lowestBit(mask);
+            if (keys[slot] == bidId) {
+                return slot;
+            }
+        }
+        if (match(group, EMPTY) != 0) {
+            return -1;
+        }
+        group = (group + step) & groupMask;
+    }
+    return -1;
+}
+
+/**
+ * Find the first EMPTY or DELETED slot along a key's probe
+ * sequence. The table is never full, so one always exists.
+ *
+ * @param hash The hash of the key to place
+ * @return The slot
+ */
+unsigned int FlatHashTable::findFree(uint64_t hash) const {
+    unsigned int group = (hash >> 7) & groupMask;
+
+    for (unsigned int step = 1; ; step++) {
+        uint32_t mask = matchFree(group);
+        if (mask != 0) {
+            return group * GROUP_SIZE + lowestBit(mask);
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+/**
+ * Rebuild the tag and key arrays with a number of groups,
+ * dropping tombstones. Bids stay where they are; only their
+ * refs move with the keys.
+ *
+ * @param groups The new number of groups, a power of two
+ */
+void FlatHashTable::rehash(unsigned int groups) {
+    vector<int8_t> oldControl(groups * GROUP_SIZE, EMPTY);
+    vector<string> oldKeys(groups * GROUP_SIZE);
+    vector<unsigned int> oldRefs(groups * GROUP_SIZE);
+    control.swap(oldControl);
+    keys.swap(oldKeys);
+    refs.swap(oldRefs);
+    groupMask = groups - 1;
+    tombstones = 0;
+
+    for (unsigned int i = 0; i < oldControl.size(); i++) {
+        if (oldControl[i] >= 0) {
+            unsigned int slot = findFree(hash(oldKeys[i]));
+            control[slot] = oldControl[i];
+            keys[slot].swap(oldKeys[i]);
+            refs[slot] = oldRefs[i];
+        }
+    }
+}
+
+/**
+ * Insert a bid. Unlike the chained table, a bid whose id
+ * is already present replaces the stored one.
+ *
+ * @param bid The bid to insert
+ */
+void FlatHashTable::Insert(Bid bid) {
+    uint64_t h = hash(bid.bidId);
+    int slot = find(bid.bidId, h);
+    if (slot >= 0) {
+        bids[refs[slot]] = bid;
+        return;
+    }
+
+    // Keep at least 1/8 of the slots EMPTY so probes stay short. If
+    // most of the used slots are tombstones, rehashing in place is enough.
+    unsigned int capacity = control.size();
+    if ((count + tombstones + 1) * 8 > capacity * 7) {
+        rehash((count + 1) * 16 > capacity * 7 ? (groupMask + 1) * 2 : groupMask + 1);
+    }
+
+    slot = findFree(h);
+    if (control[slot] == DELETED) {
+        tombstones--;
+    }
+    control[slot] = h & 0x7F;
+    keys[slot] = bid.bidId;
+
+    // Reuse a removed bid's entry before growing the payload array
+    if (!freeBids.empty()) {
+        refs[slot] = freeBids.back();
+        freeBids.pop_back();
+        bids[refs[slot]] = bid;
+    }
+    else {
+        refs[slot] = bids.size();
+        bids.push_back(bid);
+    }
+    count++;
+}
+
+/**
+ * Print all bids
+ */
+void FlatHashTable::PrintAll() {
+    for (unsigned int i = 0; i < control.size(); i++) {
+        if (control[i] >= 0) {
+            const Bid& bid = bids[refs[i]];
+            cout << "Slot " << i << ": " << bid.bidId << "| " << bid.title << " | " << bid.amount << " | "
+                << funds.lookup(bid.fundId) << endl;
+        }
+    }
+}
+
+/**
+ * Remove a bid. The slot becomes a tombstone so probes
+ * for keys placed after it still run past it.
+ *
+ * @param bidId The bid id to search for
+ */
+void FlatHashTable::Remove(string bidId) {
+    int slot = find(bidId, hash(bidId));
+    if (slot < 0) {
+        return;
+    }
+
+    control[slot] = DELETED;
+    keys[slot].clear();
+    bids[refs[slot]] = Bid();
+    freeBids.push_back(refs[slot]);
+    count--;
+    tombstones++;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid FlatHashTable::Search(string bidId) {
+    int slot = find(bidId, hash(bidId));
+    if (slot < 0) {
+        return Bid();
+    }
+    return bids[refs[slot]];
+}
+
+/**
+ * Fraction of the slots holding a bid
+ */
+double FlatHashTable::LoadFactor() {
+    return count * 1.0 / control.size();
+}
+
+//============================================================================
+// Concurrent Hash Table class definition
+//============================================================================
+
+/**
+ * Gives each thread that reads a ConcurrentHashTable one of
+ * MAX_READERS slot numbers for as long as the thread lives.
+ * The numbers are shared by every table.
+ */
+class ReaderSlot {
+
+private:
+    static atomic<bool> claimed[MAX_READERS];
+    unsigned int index;
+
+    ReaderSlot();
+    ~ReaderSlot();
+
+public:
+    static unsigned int Index();
+};
+
+atomic<bool> ReaderSlot::claimed[MAX_READERS];
+
+/**
+ * Claim the first free slot, waiting for a thread to exit
+ * if every slot is taken
+ */
+ReaderSlot::ReaderSlot() {
+    for (;;) {
+        for (unsigned int i = 0; i < MAX_READERS; i++) {
+            bool expected = false;
+            if (!claimed[i].load(memory_order_relaxed) && claimed[i].compare_exchange_strong(expected, true)) {
+                index = i;
+                return;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+/**
+ * Give the slot back when the thread exits
+ */
+ReaderSlot::~ReaderSlot() {
+    claimed[index].store(false, memory_order_release);
+}
+
+/**
+ * The calling thread's slot, claimed on first use
+ */
+unsigned int ReaderSlot::Index() {
+    static thread_local ReaderSlot slot;
+    return slot.index;
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement a hash table with chaining that many threads
+ * can use at once.
+ *
+ * Readers take no locks: they announce the epoch they read
+ * in and follow the chains with acquire loads. Writers lock
+ * one of LOCK_STRIPES mutexes picked by bucket and publish
+ * every change with a single release store, so a reader sees
+ * a chain either before or after it. Nodes are never changed
+ * in place; a removed or replaced node is retired and only
+ * freed once every reader that might still hold it is gone.
+ */
+class ConcurrentHashTable {
+
+private:
+    struct Node {
+        const Bid bid;
+        const uint64_t key; // full hash of bid.bidId
+        atomic<Node*> next;
+
+        Node(const Bid& aBid, uint64_t aKey, Node* aNext) : bid(aBid), key(aKey), next(aNext) {
+        }
+    };
+
+    // epoch a reader entered in, 0 when it isn't reading;
+    // each on its own cache line so readers don't share one
+    struct alignas(64) ReaderEpoch {
+        atomic<uint64_t> epoch{ 0 };
+    };
+
+    // announces the calling thread as a reader while in scope
+    class ReadGuard {
+    private:
+        atomic<uint64_t>& epoch;
+    public:
+        ReadGuard(ConcurrentHashTable& table);
+        ~ReadGuard();
+    };
+
+    unique_ptr<atomic<Node*>[]> buckets;
+    unsigned int tableSize;
+    unsigned int tableMask;
+    atomic<unsigned int> size{ 0 };
+    mutex locks[LOCK_STRIPES];
+
+    ReaderEpoch readers[MAX_READERS];
+    atomic<uint64_t> globalEpoch{ 1 };
+
+    // nodes unlinked by writers, with the epoch they were unlinked in
+    mutex retireLock;
+    vector<pair<uint64_t, Node*> > retired;
+    unsigned int retireCount = 0;
+
+    IntegerHash hasher;
+
+    void retire(Node* node);
+    void reclaim();
+
+public:
+    ConcurrentHashTable();
+    ConcurrentHashTable(unsigned int size);
+    virtual ~ConcurrentHashTable();
+    void Insert(Bid bid);
+    void PrintAll();
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    unsigned int Size();
+};
+
+/**
+ * Enter a read: publish the current epoch, then fence so
+ * the announcement is visible before any node is loaded
+ */
+ConcurrentHashTable::ReadGuard::ReadGuard(ConcurrentHashTable& table)
+    : epoch(table.readers[ReaderSlot::Index()].epoch) {
+    epoch.store(table.globalEpoch.load(memory_order_relaxed), memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * Leave a read; nothing loaded during it may be used after
+ */
+ConcurrentHashTable::ReadGuard::~ReadGuard() {
+    epoch.store(0, memory_order_release);
+}
+
+/**
+ * Default constructor
+ */
+ConcurrentHashTable::ConcurrentHashTable() : ConcurrentHashTable(DEFAULT_SIZE) {
+}
+
+/**
+ * Constructor for specifying size of the table
+ * The table doesn't grow, so size it for the expected
+ * number of bids. The size is rounded up to a power of two.
+ */
+ConcurrentHashTable::ConcurrentHashTable(unsigned int size) {
+    tableSize = 1;
+    while (tableSize < size) {
+        tableSize *= 2;
+    }
+    tableMask = tableSize - 1;
+
+    buckets.reset(new atomic<Node*>[tableSize]);
+    for (unsigned int i = 0; i < tableSize; i++) {
+        buckets[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructor; no other thread may be using the table
+ */
+ConcurrentHashTable::~ConcurrentHashTable() {
+    for (unsigned int i = 0; i < tableSize; i++) {
+        Node* node = buckets[i].load(memory_order_relaxed);
+        while (node != nullptr) {
+            Node* next = node->next.load(memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+    for (pair<uint64_t, Node*>& entry : retired) {
+        delete entry.second;
+    }
+}
+
+/**
+ * Hand an unlinked node over to be freed later
+ *
+ * @param node The node no longer reachable from any bucket
+ */
+void ConcurrentHashTable::retire(Node* node) {
+    lock_guard<mutex> lock(retireLock);
+    retired.push_back(make_pair(globalEpoch.load(), node));
+    if (++retireCount % RECLAIM_INTERVAL == 0) {
+        reclaim();
+    }
+}
+
+/**
+ * Advance the epoch if every active reader has caught up
+ * with it, then free the nodes retired two or more epochs
+ * ago: any reader that could have reached one has left.
+ * Called with retireLock held.
+ */
+void ConcurrentHashTable::reclaim() {
+    // order the unlinks before the scan; pairs with the fence in ReadGuard
+    atomic_thread_fence(memory_order_seq_cst);
+
+    uint64_t epoch = globalEpoch.load();
+    bool caughtUp = true;
+    for (unsigned int i = 0; i < MAX_READERS && caughtUp; i++) {
+        uint64_t reader = readers[i].epoch.load();
+        caughtUp = reader == 0 || reader == epoch;
+    }
+    if (caughtUp) {
+        globalEpoch.store(++epoch);
+    }
+
+    vector<pair<uint64_t, Node*> >::iterator kept = retired.begin();
+    for (pair<uint64_t, Node*>& entry : retired) {
+        if (entry.first + 2 <= epoch) {
+            delete entry.second;
+        }
+        else {
+            *kept++ = entry;
+        }
+    }
+    retired.erase(kept, retired.end());
+}
+
+/**
+ * Insert a bid. A bid whose id is already present is
+ * replaced by a new node, so readers never see it half written.
+ *
+ * @param bid The bid to insert
+ */
+void ConcurrentHashTable::Insert(Bid bid) {
+    uint64_t key = hasher(bid.bidId);
+    atomic<Node*>& head = buckets[key & tableMask];
+    lock_guard<mutex> lock(locks[key & tableMask & (LOCK_STRIPES - 1)]);
+
+    for (atomic<Node*>* link = &head; link->load(memory_order_relaxed) != nullptr; ) {
+        Node* node = link->load(memory_order_relaxed);
+        if (node->key == key && node->bid.bidId == bid.bidId) {
+            link->store(new Node(bid, key, node->next.load(memory_order_relaxed)), memory_order_release);
+            retire(node);
+            return;
+        }
+        link = &node->next;
+    }
+
+    head.store(new Node(bid, key, head.load(memory_order_relaxed)), memory_order_release);
+    size++;
+}
+
+/**
+ * Print all bids
+ */
+void ConcurrentHashTable::PrintAll() {
+    ReadGuard guard(*this);
+
+    for (unsigned int i = 0; i < tableSize; i++) {
+        Node* node = buckets[i].load(memory_order_acquire);
+        for (; node != nullptr; node = node->next.load(memory_order_acquire)) {
+            cout << "Key " << i << ": " << node->bid.bidId << "| " << node->bid.title << " | " << node->bid.amount << " | "
+                << funds.lookup(node->bid.fundId) << endl;
+        }
+    }
+}
+
+/**
+ * Remove a bid. The node keeps its next pointer, so a reader
+ * standing on it can still walk on down the chain.
+ *
+ * @param bidId The bid id to search for
+ */
+void ConcurrentHashTable::Remove(string bidId) {
+    uint64_t key = hasher(bidId);
+    lock_guard<mutex> lock(locks[key & tableMask & (LOCK_STRIPES - 1)]);
+
+    for (atomic<Node*>* link = &buckets[key & tableMask]; link->load(memory_order_relaxed) != nullptr; ) {
+        Node* node = link->load(memory_order_relaxed);
+        if (node->key == key && node->bid.bidId == bidId) {
+            link->store(node->next.load(memory_order_relaxed), memory_order_release);
+            retire(node);
+            size--;
+            return;
+        }
+        link = &node->next;
+    }
+}
+
+/**
+ * Search for the specified bidId without taking a lock
+ *
+ * @param bidId The bid id to search for
+ */
+Bid ConcurrentHashTable::Search(string bidId) {
+    uint64_t key = hasher(bidId);
+    ReadGuard guard(*this);
+
+    Node* node = buckets[key & tableMask].load(memory_order_acquire);
+    for (; node != nullptr; node = node->next.load(memory_order_acquire)) {
+        if (node->key == key && node->bid.bidId == bidId) {
+            return node->bid;
+        }
+    }
+    return Bid();
+}
+
+/**
+ * Number of bids in the table
+ */
+unsigned int ConcurrentHashTable::Size() {
+    return size.load();
+}
+
+//============================================================================
+// Static Bid Index class definition
+//============================================================================
+
+/**
+ * Map a 64 bit value onto [0, n) with a multiply instead of a
+ * modulo; the value's high bits pick the result
+ */
+inline uint64_t reduce(uint64_t value, uint64_t n) {
+    multiply128(value, n);
+    return n;
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement a read-only index of a fixed set of bids.
+ *
+ * A minimal perfect hash, built PTHash style, gives every bid id
+ * its own entry: ids are split into buckets of about
+ * KEYS_PER_BUCKET, and each bucket stores the pilot value that
+ * sent its ids to entries no other bucket uses. A lookup hashes
+ * the id, reads its bucket's pilot, and checks the one entry
+ * that id can be in.
+ *
+ * The whole index is a single image holding offsets, never
+ * pointers, so it can be written to a file and mapped back as is.
+ */
+class StaticBidIndex {
+
+private:
+    static constexpr char MAGIC[8] = { 'B', 'I', 'D', 'I', 'N', 'D', 'X', '\0' };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t KEYS_PER_BUCKET = 4;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;       // entries, one per bid
+        uint32_t bucketCount; // pilots
+        uint32_t fundCount;   // fund names
+        uint64_t pilots;      // offsets of each section from the image start
+        uint64_t entries;
+        uint64_t funds;
+        uint64_t strings;
+        uint64_t size;        // bytes in the whole image
+    };
+
+    struct Entry {
+        uint64_t hash; // StringHash of the bid id, checked before the id itself
+        uint32_t bidId;
+        uint32_t bidIdLength;
+        uint32_t title;
+        uint32_t titleLength;
+        uint32_t fund; // index into the fund names
+        uint32_t reserved;
+        double amount;
+    };
+
+    struct FundName {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    vector<uint64_t> image;                // the image when built here
+    unique_ptr<csv::MappedFile> mapped;    // or when mapped from a file
+    const Header* header = nullptr;
+    const uint32_t* pilots = nullptr;
+    const Entry* entries = nullptr;
+    const char* strings = nullptr;
+    vector<csv::Dictionary::Id> fundIds;   // fund name index to funds id
+
+    static unsigned int position(uint64_t hash, uint32_t pilot, uint32_t count);
+    void attach(const char* data, size_t size);
+
+public:
+    StaticBidIndex(const vector<Bid>& bids);
+    StaticBidIndex(string path);
+    void Save(string path);
+    Bid Search(string bidId);
+    unsigned int Size();
+    size_t MemoryUsage();
+};
+
+constexpr char StaticBidIndex::MAGIC[8];
+
+/**
+ * The entry a key goes to under a pilot value
+ *
+ * @param hash The key's hash
+ * @param pilot The pilot of the key's bucket
+ * @param count The number of entries
+ */
+unsigned int StaticBidIndex::position(uint64_t hash, uint32_t pilot, uint32_t count) {
+    return reduce(mix(hash ^ pilot, 0x9e3779b97f4a7c15ULL), count);
+}
+
+/**
+ * Build the index over a set of bids. A repeated bid id
+ * keeps its first bid.
+ *
+ * @param bids The bids to index
+ */
+StaticBidIndex::StaticBidIndex(const vector<Bid>& bids) {
+    StringHash hasher;
+
+    // Hash every id once, sorted so repeats sit side by side
+    vector<pair<uint64_t, unsigned int> > keys;
+    keys.reserve(bids.size());
+    for (unsigned int i = 0; i < bids.size(); i++) {
+        keys.push_back(make_pair(hasher(bids[i].bidId), i));
+    }
+    stable_sort(keys.begin(), keys.end(),
+        [](const pair<uint64_t, unsigned int>& a, const pair<uint64_t, unsigned int>& b) { return a.first < b.first; });
+
+    unsigned int unique = 0;
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        if (unique > 0 && keys[unique - 1].first == keys[i].first) {
+            if (bids[keys[unique - 1].second].bidId != bids[keys[i].second].bidId) {
+                throw csv::Error("StaticBidIndex: two bid ids share a hash");
+            }
+            continue;
+        }
+        keys[unique++] = keys[i];
+    }
+    keys.resize(unique);
+
+    uint32_t count = keys.size();
+    uint32_t bucketCount = count / KEYS_PER_BUCKET + 1;
+
+    // Group the keys by bucket
+    vector<uint32_t> bucketStart(bucketCount + 1, 0);
+    for (const pair<uint64_t, unsigned int>& key : keys) {
+        bucketStart[reduce(key.first, bucketCount) + 1]++;
+    }
+    for (uint32_t b = 0; b < bucketCount; b++) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+    vector<uint64_t> bucketKeys(count);
+    vector<uint32_t> filled(bucketStart.begin(), bucketStart.end() - 1);
+    for (const pair<uint64_t, unsigned int>& key : keys) {
+        bucketKeys[filled[reduce(key.first, bucketCount)]++] = key.first;
+    }
+
+    // Place the biggest buckets first, while most entries are free
+    vector<uint32_t> order(bucketCount);
+    for (uint32_t b = 0; b < bucketCount; b++) {
+        order[b] = b;
+    }
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+    });
+
+    vector<uint32_t> bucketPilots(bucketCount, 0);
+    vector<bool> taken(count, false);
+    vector<unsigned int> placed;
+    for (uint32_t b : order) {
+        for (uint32_t pilot = 0; ; pilot++) {
+            placed.clear();
+            for (uint32_t k = bucketStart[b]; k < bucketStart[b + 1]; k++) {
+                unsigned int slot = position(bucketKeys[k], pilot, count);
+                if (taken[slot] || find(placed.begin(), placed.end(), slot) != placed.end()) {
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (placed.size() == bucketStart[b + 1] - bucketStart[b]) {
+                for (unsigned int slot : placed) {
+                    taken[slot] = true;
+                }
+                bucketPilots[b] = pilot;
+                break;
+            }
+        }
+    }
+
+    // Put each bid in its entry; strings follow in entry order so a
+    // hit reads its id and title from one place
+    vector<unsigned int> bidAt(count);
+    for (const pair<uint64_t, unsigned int>& key : keys) {
+        uint32_t b = reduce(key.first, bucketCount);
+        bidAt[position(key.first, bucketPilots[b], count)] = key.second;
+    }
+
+    vector<Entry> entryList(count);
+    vector<FundName> fundList;
+    vector<int> fundIndex(funds.size(), -1);
+    string heap;
+    for (uint32_t i = 0; i < count; i++) {
+        const Bid& bid = bids[bidAt[i]];
+        Entry& entry = entryList[i];
+        entry.hash = hasher(bid.bidId);
+        entry.bidId = heap.size();
+        entry.bidIdLength = bid.bidId.size();
+        heap += bid.bidId;
+        entry.title = heap.size();
+        entry.titleLength = bid.title.size();
+        heap += bid.title;
+        entry.reserved = 0;
+        entry.amount = bid.amount;
+
+        if (fundIndex[bid.fundId] < 0) {
+            const string& name = funds.lookup(bid.fundId);
+            fundIndex[bid.fundId] = fundList.size();
+            fundList.push_back({ (uint32_t) heap.size(), (uint32_t) name.size() });
+            heap += name;
+        }
+        entry.fund = fundIndex[bid.fundId];
+    }
+
+    // Lay the sections out on 8 byte boundaries
+    Header top = {};
+    memcpy(top.magic, MAGIC, sizeof(MAGIC));
+    top.version = VERSION;
+    top.count = count;
+    top.bucketCount = bucketCount;
+    top.fundCount = fundList.size();
+    top.pilots = sizeof(Header);
+    top.entries = (top.pilots + bucketCount * sizeof(uint32_t) + 7) & ~7ULL;
+    top.funds = top.entries + count * sizeof(Entry);
+    top.strings = top.funds + fundList.size() * sizeof(FundName);
+    top.size = top.strings + heap.size();
+
+    image.assign((top.size + 7) / 8, 0);
+    char* data = reinterpret_cast<char*>(image.data());
+    memcpy(data, &top, sizeof(top));
+    memcpy(data + top.pilots, bucketPilots.data(), bucketCount * sizeof(uint32_t));
+    if (count > 0) {
+        memcpy(data + top.entries, entryList.data(), count * sizeof(Entry));
+        memcpy(data + top.funds, fundList.data(), fundList.size() * sizeof(FundName));
+        memcpy(data + top.strings, heap.data(), heap.size());
+    }
+
+    attach(data, top.size);
+}
+
+/**
+ * Map an index written by Save
+ *
+ * @param path The index file
+ */
+StaticBidIndex::StaticBidIndex(string path) {
+    mapped.reset(new csv::MappedFile(path, csv::eRANDOM));
+    attach(mapped->data(), mapped->size());
+}
+
+/**
+ * Check an image and point the section views into it
+ *
+ * @param data The image
+ * @param size The bytes in the image
+ */
+void StaticBidIndex::attach(const char* data, size_t size) {
+    // Each offset is checked against the image size before it is
+    // added to, so no sum can wrap
+    const Header* top = reinterpret_cast<const Header*>(data);
+    if (size < sizeof(Header) || memcmp(top->magic, MAGIC, sizeof(MAGIC)) != 0 || top->version != VERSION
+        || top->size != size || top->bucketCount == 0
+        || top->pilots < sizeof(Header) || top->pilots > size || top->pilots % alignof(uint32_t) != 0
+        || top->entries > size || top->entries % alignof(Entry) != 0
+        || top->entries < top->pilots + top->bucketCount * (uint64_t) sizeof(uint32_t)
+        || top->funds != top->entries + top->count * (uint64_t) sizeof(Entry)
+        || top->strings != top->funds + top->fundCount * (uint64_t) sizeof(FundName) || top->strings > size) {
+        throw csv::Error("StaticBidIndex: not a bid index image");
+    }
+
+    // Every string an entry or fund name points at must lie in the
+    // image, and every fund index name a fund, so Search needn't check
+    const Entry* entryList = reinterpret_cast<const Entry*>(data + top->entries);
+    const FundName* names = reinterpret_cast<const FundName*>(data + top->funds);
+    uint64_t heapSize = size - top->strings;
+    for (uint32_t i = 0; i < top->count; i++) {
+        const Entry& entry = entryList[i];
+        if ((uint64_t) entry.bidId + entry.bidIdLength > heapSize
+            || (uint64_t) entry.title + entry.titleLength > heapSize || entry.fund >= top->fundCount) {
+            throw csv::Error("StaticBidIndex: corrupted bid index image");
+        }
+    }
+    for (uint32_t i = 0; i < top->fundCount; i++) {
+        if ((uint64_t) names[i].offset + names[i].length > heapSize) {
+            throw csv::Error("StaticBidIndex: corrupted bid index image");
+        }
+    }
+
+    header = top;
+    pilots = reinterpret_cast<const uint32_t*>(data + top->pilots);
+    entries = entryList;
+    strings = data + top->strings;
+
+    // Fund names are stored as text and given this process's ids
+    fundIds.clear();
+    for (uint32_t i = 0; i < top->fundCount; i++) {
+        fundIds.push_back(funds.intern(string_view(strings + names[i].offset, names[i].length)));
+    }
+}
+
+/**
+ * Write the index image to a file, through a temporary
+ * file so a reader never maps half an index
+ *
+ * @param path The file to write
+ */
+void StaticBidIndex::Save(string path) {
+    string temp = path + ".tmp";
+    {
+        ofstream out(temp.c_str(), ios::out | ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(header), header->size);
+        if (!out.flush()) {
+            throw csv::Error("Failed to write " + temp);
+        }
+    }
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+        throw csv::Error("Failed to write " + path);
+    }
+}
+
+/**
+ * Search for the specified bidId with a single probe
+ *
+ * @param bidId The bid id to search for
+ */
+Bid StaticBidIndex::Search(string bidId) {
+    Bid bid;
+    if (header->count == 0) {
+        return bid;
+    }
+
+    uint64_t hash = StringHash()(bidId);
+    uint32_t pilot = pilots[reduce(hash, header->bucketCount)];
+    const Entry& entry = entries[position(hash, pilot, header->count)];
+
+    if (entry.hash == hash && string_view(strings + entry.bidId, entry.bidIdLength) == bidId) {
+        bid.bidId = bidId;
+        bid.title.assign(strings + entry.title, entry.titleLength);
+        bid.fundId = fundIds[entry.fund];
+        bid.amount = entry.amount;
+    }
+    return bid;
+}
+
+/**
+ * Number of bids in the index
+ */
+unsigned int StaticBidIndex::Size() {
+    return header->count;
+}
+
+/**
+ * Bytes held by the index image
+ */
+size_t StaticBidIndex::MemoryUsage() {
+    return header->size;
+}
+
+/**
+ * Define a class containing data members and methods to look
+ * bids up in a BidTable image: the table's buckets and bids
+ * written to a file with offsets in place of pointers, then
+ * mapped read-only. Opening one maps pages instead of parsing
+ * the CSV and building a table, and every process that maps
+ * the same file shares one copy of it.
+ *
+ * A bid is stored as its amount, the length of its title, the
+ * index of its fund name and the title. The fund names are kept
+ * once, after the table, and given this process's ids when the
+ * image is opened.
+ */
+class MappedBidTable {
+
+private:
+    csv::MappedFile file;
+    HashImage<IntegerHash> image;
+    vector<csv::Dictionary::Id> fundIds; // fund name index to funds id
+
+    static void encode(const Bid& bid, string& out);
+
+public:
+    MappedBidTable(string path);
+    static void Save(BidTable& table, string path);
+    Bid Search(string bidId);
+    unsigned int Size();
+    size_t MemoryUsage();
+};
+
+/**
+ * Map an image written by Save
+ *
+ * @param path The image file
+ */
+MappedBidTable::MappedBidTable(string path)
+    : file(path, csv::eRANDOM), image(file.data(), file.size()) {
+    // Each fund name is its length followed by its bytes
+    string_view names = image.Extra();
+    while (!names.empty()) {
+        uint32_t length;
+        if (names.size() < sizeof(length)) {
+            throw runtime_error("MappedBidTable: bad fund names in " + path);
+        }
+        memcpy(&length, names.data(), sizeof(length));
+        names.remove_prefix(sizeof(length));
+        if (length > names.size()) {
+            throw runtime_error("MappedBidTable: bad fund names in " + path);
+        }
+        fundIds.push_back(funds.intern(names.substr(0, length)));
+        names.remove_prefix(length);
+    }
+}
+
+/**
+ * Append a bid's image bytes; its id is the entry's key, and its
+ * fund id here is the index of its name in the image
+ */
+void MappedBidTable::encode(const Bid& bid, string& out) {
+    uint32_t titleLength = bid.title.size();
+    uint32_t fund = bid.fundId;
+    out.append(reinterpret_cast<const char*>(&bid.amount), sizeof(bid.amount));
+    out.append(reinterpret_cast<const char*>(&titleLength), sizeof(titleLength));
+    out.append(reinterpret_cast<const char*>(&fund), sizeof(fund));
+    out += bid.title;
+}
+
+/**
+ * Write a table's image to a file, with every fund name after it
+ *
+ * @param table The bids to write
+ * @param path The file to write
+ */
+void MappedBidTable::Save(BidTable& table, string path) {
+    string names;
+    for (csv::Dictionary::Id id = 0; id < funds.size(); id++) {
+        uint32_t length = funds.lookup(id).size();
+        names.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        names += funds.lookup(id);
+    }
+    table.SaveImage(path, encode, names);
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid MappedBidTable::Search(string bidId) {
+    Bid bid;
+    string_view value;
+    if (!image.Search(bidId, value) || value.size() < sizeof(double) + 2 * sizeof(uint32_t)) {
+        return bid;
+    }
+
+    uint32_t titleLength, fund;
+    memcpy(&bid.amount, value.data(), sizeof(double));
+    memcpy(&titleLength, value.data() + sizeof(double), sizeof(titleLength));
+    memcpy(&fund, value.data() + sizeof(double) + sizeof(uint32_t), sizeof(fund));
+    value.remove_prefix(sizeof(double) + 2 * sizeof(uint32_t));
+    if (titleLength != value.size() || fund >= fundIds.size()) {
+        return bid;
+    }
+
+    bid.bidId = bidId;
+    bid.title.assign(value.data(), titleLength);
+    bid.fundId = fundIds[fund];
+    return bid;
+}
+
+/**
+ * Number of bids in the image
+ */
+unsigned int MappedBidTable::Size() {
+    return image.Size();
+}
+
+/**
+ * Bytes in the mapped image, shared with every other process
+ * that maps it
+ */
+size_t MappedBidTable::MemoryUsage() {
+    return image.MemoryUsage();
+}
+
+//============================================================================
+// Static methods used for testing
 //============================================================================
 
-const unsigned int DEFAULT_SIZE = 179;
+/**
+ * Display the bid information to the console (std::out)
+ *
+ * @param bid struct containing the bid info
+ */
+void displayBid(Bid bid) {
+    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
+        << funds.lookup(bid.fundId) << endl;
+    return;
+}
 
-// forward declarations
-double strToDouble(string str, char ch);
+/**
+ * Display a table's statistics to the console (std::out)
+ *
+ * @param stats the statistics from HashTable::Stats
+ */
+void displayStats(const HashTableStats& stats) {
+    cout << "Buckets: " << stats.buckets << ", bids: " << stats.entries << ", load factor: " << stats.loadFactor << endl;
+    cout << "Empty buckets: " << stats.emptyBuckets << endl;
+    cout << "Chain length: median " << stats.medianChain << ", p90 " << stats.p90Chain << ", p99 "
+        << stats.p99Chain << ", max " << stats.longestChain << endl;
+    if (!HASHTABLE_STATS) {
+        cout << "Search probes: not counted in this build" << endl;
+        return;
+    }
+    cout << "Search hits: " << stats.hits << ", " << (stats.hits ? stats.hitProbes * 1.0 / stats.hits : 0.0)
+        << " probes each" << endl;
+    cout << "Search misses: " << stats.misses << ", " << (stats.misses ? stats.missProbes * 1.0 / stats.misses : 0.0)
+        << " probes each" << endl;
+}
 
-// define a structure to hold bid information
-struct Bid {
-    string bidId; // unique identifier
-    string title;
-    string fund;
-    double amount;
-    Bid() {
-        amount = 0.0;
+/**
+ * Load bids from the binary snapshot written by an earlier CSV load
+ *
+ * @param snapshotPath the path to the snapshot file
+ * @param csvPath the CSV file the snapshot must still match
+ * @return false if there is no usable snapshot
+ */
+bool loadSnapshot(string snapshotPath, string csvPath, BidTable* hashTable) {
+    // no snapshot yet is the usual first run, not a failure
+    if (!filesystem::exists(snapshotPath)) {
+        return false;
     }
-};
 
+    try {
+        csv::Snapshot snapshot(snapshotPath, csvPath);
+
+        for (unsigned int i = 0; i < snapshot.rowCount(); i++) {
+            Bid bid;
+            bid.bidId = snapshot.text(i, 0);
+            bid.title = snapshot.text(i, 1);
+            bid.fundId = funds.intern(snapshot.text(i, 2));
+            bid.amount = snapshot.number(i, 0);
+            hashTable->Insert(bid.bidId, bid);
+        }
+    }
+    catch (csv::Error& e) {
+        cout << e.what() << ", reading CSV instead" << endl;
+        return false;
+    }
 
-//============================================================================
-// Hash Table class definition
-//============================================================================
+    cout << "Loaded snapshot " << snapshotPath << endl;
+    return true;
+}
 
 /**
- * Define a class containing data members and methods to
- * implement a hash table with chaining.
+ * Load a CSV file containing bids into a container
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return a container holding all the bids read
  */
-class HashTable {
+void loadBids(string csvPath, BidTable* hashTable) {
+    // a current snapshot from an earlier load skips text parsing entirely
+    string snapshotPath = csvPath + ".snap";
+    if (loadSnapshot(snapshotPath, csvPath, hashTable)) {
+        return;
+    }
 
-private:
-    // Define structures to hold bids
-    struct Node {
-        Bid bid;
-        unsigned int key;
-        Node* next;
+    cout << "Loading CSV file " << csvPath << endl;
 
-        // default constructor
-        Node() {
-            key = UINT_MAX;
-            next = nullptr;
-        }
+    // initialize the CSV Reader, which streams the file one block at a time
+    csv::Reader file(csvPath);
 
-        // initialize with a bid
-        Node(Bid aBid) : Node() {
-            bid = aBid;
-        }
+    // bind the CSV columns to Bid fields once, checked against the header here
+    auto binder = csv::makeBinder(file.getHeader(),
+        csv::bind(1, &Bid::bidId, csv::AsString()),
+        csv::bind(0, &Bid::title, csv::AsString()),
+        csv::bind(8, &Bid::fundId, csv::AsInterned(funds)),
+        csv::bind(4, &Bid::amount, csv::AsCurrency()));
 
-        // initialize with a bid and a key
-        Node(Bid aBid, unsigned int aKey) : Node(aBid) {
-            key = aKey;
-        }
-    };
+    // only the bound columns are parsed, the others are skipped
+    file.project(binder.columns());
+
+    // read and display header row - optional
+    vector<string> header = file.getHeader();
+    for (auto const& c : header) {
+        cout << c << " | ";
+    }
+    cout << "" << endl;
 
-    vector<Node> nodes;
+    // remember what is read so the next load can map it instead
+    csv::SnapshotWriter snapshot(3, 1);
 
-    unsigned int tableSize = DEFAULT_SIZE;
+    try {
+        // hand each row of the CSV file straight to the container
+        file.forEachRow([&](const csv::Row& row) {
 
-    unsigned int hash(int key);
+            // fill a bid straight from the field views, no temporary strings
+            Bid bid;
+            binder.fill(row, bid);
 
-public:
-    HashTable();
-    HashTable(unsigned size);
-    virtual ~HashTable();
-    void Insert(Bid bid);
-    void PrintAll();
-    void Remove(string bidId);
-    Bid Search(string bidId);
-};
+            // record the same fields for the snapshot
+            snapshot.add({ row.view(1), row.view(0), row.view(8) }, { bid.amount });
+
+            //cout << "Item: " << bid.title << ", Fund: " << funds.lookup(bid.fundId) << ", Amount: " << bid.amount << endl;
+
+            // push this bid to the end
+            hashTable->Insert(bid.bidId, bid);
+        });
+
+        snapshot.write(snapshotPath, csvPath);
+    }
+    catch (csv::Error& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
 
 /**
- * Default constructor
+ * Insert and look up bids the same way in every kind of table so
+ * one benchmark can time them all. HashTable takes the key apart
+ * from the bid and returns a pointer; the other tables take and
+ * return whole bids.
  */
-HashTable::HashTable() {
+template <typename Hash>
+void insertBid(HashTable<string, Bid, Hash>& table, const Bid& bid) {
+    table.Insert(bid.bidId, bid);
+}
 
-    // Initalize node structure and resize to integer tableSize
-    nodes.resize(tableSize);
+template <typename Table>
+void insertBid(Table& table, const Bid& bid) {
+    table.Insert(bid);
+}
+
+template <typename Hash>
+bool findBid(HashTable<string, Bid, Hash>& table, const string& bidId) {
+    return table.Search(bidId) != nullptr;
+}
+
+template <typename Table>
+bool findBid(Table& table, const string& bidId) {
+    return !table.Search(bidId).bidId.empty();
 }
 
 /**
- * Constructor for specifying size of the table
- * Use to improve efficiency of hashing algorithm
- * by reducing collisions without wasting memory.
+ * Make bids with distinct, scattered numeric ids for benchmarking
+ *
+ * @param count number of bids to make
+ * @return the bids
  */
-HashTable::HashTable(unsigned int size) {
-    // Set tableSize to size and resize structure to tableSize
-    this->tableSize = size;
-    nodes.resize(tableSize);
+vector<Bid> makeBids(unsigned int count) {
+    vector<Bid> bids(count);
+    csv::Dictionary::Id fund = funds.intern("General Fund");
+
+    for (unsigned int i = 0; i < count; i++) {
+        // 48271 is prime, so no two ids below 90 million collide
+        bids[i].bidId = to_string(10000000 + (i * 48271ULL) % 90000000);
+        bids[i].title = "Surplus item " + to_string(i);
+        bids[i].fundId = fund;
+        bids[i].amount = i % 1000 + 0.99;
+    }
+    return bids;
 }
 
-
 /**
- * Destructor
+ * Display the time one phase of a benchmark took per operation
  */
-HashTable::~HashTable() {
-    // Free storage when a class is destroyed
-    nodes.erase(nodes.begin());
+void displayTime(string label, clock_t ticks, unsigned int operations) {
+    cout << "  " << label << ": " << ticks * 1.0e9 / CLOCKS_PER_SEC / operations << " ns/op" << endl;
 }
 
 /**
- * Calculate the hash value of a given key.
- * Note that key is specifically defined as
- * unsigned int to prevent undefined results
- * of a negative list index.
+ * Time inserts, successful searches and failed searches
+ * on one table
  *
- * @param key The key to hash
- * @return The calculated hash
+ * @param table an empty table
+ * @param bids the first count bids are inserted, the rest are misses
+ * @param count number of bids to insert
  */
-unsigned int HashTable::hash(int key) {
-    // Calculate and return hash value
-    return key % tableSize;
+template <typename Table>
+void timeTable(string label, Table& table, const vector<Bid>& bids, unsigned int count) {
+    unsigned int found = 0;
+    clock_t ticks;
+
+    cout << label << endl;
+
+    ticks = clock();
+    for (unsigned int i = 0; i < count; i++) {
+        insertBid(table, bids[i]);
+    }
+    displayTime("insert", clock() - ticks, count);
+
+    ticks = clock();
+    for (unsigned int i = 0; i < count; i++) {
+        found += findBid(table, bids[i].bidId);
+    }
+    displayTime("hit   ", clock() - ticks, count);
+
+    ticks = clock();
+    for (unsigned int i = count; i < bids.size(); i++) {
+        found += findBid(table, bids[i].bidId);
+    }
+    displayTime("miss  ", clock() - ticks, bids.size() - count);
+
+    if (found != count) {
+        cout << "  found " << found << " of " << count << " bids" << endl;
+    }
 }
 
 /**
- * Insert a bid
+ * Compare the chained and flat tables with the same number of
+ * buckets and slots, filled to increasingly high load factors
  *
- * @param bid The bid to insert
+ * @param capacity number of buckets or slots in each table
  */
-void HashTable::Insert(Bid bid) {
-    // Assign key to hash
-    // Use atoi function to convert bidId to integer that can be passed to hash function
-    unsigned key = hash(atoi(bid.bidId.c_str()));
+void benchmarkTables(unsigned int capacity) {
+    const double LOAD_FACTORS[] = { 0.5, 0.75, 0.875 };
+
+    for (double loadFactor : LOAD_FACTORS) {
+        unsigned int count = capacity * loadFactor;
+        vector<Bid> bids = makeBids(count * 2);
+
+        cout << "Load factor " << loadFactor << ", " << count << " bids in " << capacity << " buckets" << endl;
 
-    // Set previousNode to node at key
-    Node* previousNode = &(nodes.at(key));
+        BidTable chained(capacity);
+        timeTable("HashTable", chained, bids, count);
 
-    // If node is not found, assign to key position and insert into structure 
-    if (previousNode == nullptr) {
-        Node* newNode = new Node(bid, key);
-        nodes.insert(nodes.begin() + key, (*newNode));
+        FlatHashTable flat(capacity);
+        timeTable("FlatHashTable", flat, bids, count);
     }
+}
 
-    else {
+/**
+ * Load bids into a table with one hash policy and display its
+ * chain lengths and lookup time
+ *
+ * @param bids the bids to insert and then search for
+ */
+template <typename Hash>
+void timePolicy(string label, const vector<Bid>& bids) {
+    HashTable<string, Bid, Hash> table(bids.size() * 4 / 3);
+    unsigned int found = 0;
 
-        // If node is found, set key, bid, and next
-        // Allows for chaining
-        if (previousNode->key == UINT_MAX) {
-            previousNode->key = key;
-            previousNode->bid = bid;
-            previousNode->next = nullptr;
-        }
+    for (const Bid& bid : bids) {
+        table.Insert(bid.bidId, bid);
+    }
 
-        // Else loop to find the next open node
-        else {
-            while (previousNode->next != nullptr) {
-                previousNode = previousNode->next;
-            }
+    clock_t ticks = clock();
+    for (const Bid& bid : bids) {
+        found += table.Search(bid.bidId) != nullptr;
+    }
+    ticks = clock() - ticks;
+
+    // a hit on the i-th node of a chain walks i nodes
+    unsigned int longest = 0;
+    unsigned int empty = 0;
+    unsigned long long walked = 0;
+    for (unsigned int length : table.ChainLengths()) {
+        longest = max(longest, length);
+        empty += length == 0;
+        walked += length * (length + 1ULL) / 2;
+    }
 
-        // Add new newNode to end
-        previousNode->next = new Node(bid, key);
-        }
+    cout << "  " << label << ": longest chain " << longest << ", " << walked * 1.0 / bids.size()
+        << " nodes per hit, " << empty << " empty buckets, "
+        << ticks * 1.0e9 / CLOCKS_PER_SEC / bids.size() << " ns/op" << endl;
+    if (found != bids.size()) {
+        cout << "  found " << found << " of " << bids.size() << " bids" << endl;
     }
 }
 
 /**
- * Print all bids
+ * Compare the hash policies on sequential ids like the monthly
+ * files', on scattered numeric ids and on text ids
+ *
+ * @param count number of bids in each set
  */
-void HashTable::PrintAll() {
-    // Declare local variables
-    Node* node;
-    Bid bid;
-    
-    // Loop through bids from beginning to end
-    for (unsigned i = 0; i < nodes.size(); i++) {
-        node = &nodes.at(i);
+void benchmarkPolicies(unsigned int count) {
+    vector<Bid> sequential = makeBids(count);
+    vector<Bid> text = makeBids(count);
+    for (unsigned int i = 0; i < count; i++) {
+        sequential[i].bidId = to_string(97000 + i);
+        text[i].bidId = "INV" + to_string(i);
+    }
 
-        // Print first bid in chain
-        if (node->key != UINT_MAX) {
-            cout << "Key " << i << ": " << node->bid.bidId << "| " << node->bid.title << " | " << node->bid.amount << " | "
-                << node->bid.fund << endl;
+    vector<Bid> scattered = makeBids(count);
+    const string NAMES[] = { "sequential ids", "scattered ids", "text ids" };
+    const vector<Bid>* SETS[] = { &sequential, &scattered, &text };
 
-            // Print bids after first in chain
-            while (node->next != nullptr) {
-                cout << "    " << i << ": " << node->next->bid.bidId << "| " << node->next->bid.title << " | " << node->next->bid.amount << " | "
-                    << node->next->bid.fund << endl;
-                node = node->next;
-            }
-        }
+    for (unsigned int i = 0; i < 3; i++) {
+        cout << count << " " << NAMES[i] << endl;
+        timePolicy<AtoiHash>("AtoiHash   ", *SETS[i]);
+        timePolicy<IntegerHash>("IntegerHash", *SETS[i]);
+        timePolicy<StringHash>("StringHash ", *SETS[i]);
     }
 }
 
 /**
- * Remove a bid
+ * Display the median, 99th percentile and worst of a set of timings
  *
- * @param bidId The bid id to search for
+ * @param nanoseconds the time of each operation, sorted in place
  */
-void HashTable::Remove(string bidId) {
+void displayPercentiles(string label, vector<double>& nanoseconds) {
+    sort(nanoseconds.begin(), nanoseconds.end());
+    cout << "  " << label << ": p50 " << nanoseconds[nanoseconds.size() / 2] << " ns, p99 "
+        << nanoseconds[nanoseconds.size() * 99 / 100] << " ns, max " << nanoseconds.back() << " ns" << endl;
+}
 
-    // Set key equal to hash atoi bidID 
-    unsigned key = hash(atoi(bidId.c_str()));
+/**
+ * Check that a table's statistics agree with each other: the
+ * buckets measured must be the table's own, a power of two the
+ * load factor is taken over, even if a resize was under way
+ *
+ * @param table the table to measure
+ */
+void checkStats(BidTable& table) {
+    HashTableStats stats = table.Stats();
+    if ((stats.buckets & (stats.buckets - 1)) != 0 || stats.loadFactor != stats.entries * 1.0 / stats.buckets
+        || stats.entries != table.Size()) {
+        cout << "  stats report " << stats.buckets << " buckets for " << stats.entries << " bids at load factor "
+            << stats.loadFactor << endl;
+    }
+}
 
-    // Remove bids and key
-    nodes.erase(nodes.begin() + key);
+/**
+ * Load bids into a table, timing every insert and a search for
+ * an earlier bid after each one
+ *
+ * @param table the table to load
+ * @param bids the bids to insert
+ */
+void timeGrowth(string label, BidTable& table, const vector<Bid>& bids) {
+    vector<double> inserts;
+    vector<double> searches;
+    unsigned int found = 0;
+
+    for (unsigned int i = 0; i < bids.size(); i++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        table.Insert(bids[i].bidId, bids[i]);
+        chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+        found += table.Search(bids[i * 7919ULL % (i + 1)].bidId) != nullptr;
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+        inserts.push_back(chrono::duration<double, nano>(middle - start).count());
+        searches.push_back(chrono::duration<double, nano>(end - middle).count());
+    }
 
+    cout << label << endl;
+    displayPercentiles("insert", inserts);
+    displayPercentiles("search", searches);
+    if (found != bids.size()) {
+        cout << "  found " << found << " of " << bids.size() << " bids" << endl;
+    }
+    checkStats(table);
 }
 
 /**
- * Search for the specified bidId
+ * Compare operation latency while a table grows from its default
+ * size with a table sized for every bid up front
  *
- * @param bidId The bid id to search for
+ * @param count number of bids to load
  */
-Bid HashTable::Search(string bidId) {
+void benchmarkGrowth(unsigned int count) {
+    vector<Bid> bids = makeBids(count);
 
-    // Declare local variable
-    Bid bid;
+    BidTable growing;
+    timeGrowth("growing from " + to_string(DEFAULT_SIZE) + " buckets", growing, bids);
 
-    // Assign key from bidId
-    unsigned key = hash(atoi(bidId.c_str()));
+    BidTable presized(count);
+    timeGrowth("presized to " + to_string(count) + " buckets", presized, bids);
+
+    // measure a table part way through doubling from 8 buckets
+    BidTable resizing(8);
+    for (unsigned int i = 0; i < 9 && i < count; i++) {
+        resizing.Insert(bids[i].bidId, bids[i]);
+    }
+    checkStats(resizing);
+    if (count >= 9 && resizing.Stats().buckets != 16) {
+        cout << "  stats report " << resizing.Stats().buckets << " buckets after growing to 16" << endl;
+    }
+}
 
-    // Assign node from key
-    Node* node = &(nodes.at(key));
+/**
+ * Stress test ConcurrentHashTable: reader threads look bids up
+ * while a loader thread inserts them all, replaces every other
+ * one with a higher amount and removes every third. A reader
+ * must only ever see a bid exactly as the loader wrote it.
+ *
+ * @param readers number of reader threads
+ * @param count number of bids
+ * @return true if no reader saw a bad bid and the end state is right
+ */
+bool stressConcurrent(unsigned int readers, unsigned int count) {
+    vector<Bid> bids = makeBids(count);
+    ConcurrentHashTable table(count / 4);
+    atomic<bool> loading(true);
+    atomic<unsigned int> errors(0);
+    atomic<unsigned long long> hits(0);
+
+    vector<thread> threads;
+    for (unsigned int r = 0; r < readers; r++) {
+        threads.push_back(thread([&, r]() {
+            unsigned int i = r;
+            while (loading.load()) {
+                i = (i + 7919) % count;
+                Bid bid = table.Search(bids[i].bidId);
+                if (bid.bidId.empty()) {
+                    continue;
+                }
+                hits++;
+                if (bid.bidId != bids[i].bidId || bid.title != bids[i].title || bid.fundId != bids[i].fundId
+                    || (bid.amount != bids[i].amount && bid.amount != bids[i].amount + 1)) {
+                    errors++;
+                }
+            }
+        }));
+    }
 
-    // If node matches key, return bid
-    if (node != nullptr && node->key != UINT_MAX && node->bid.bidId.compare(bidId) == 0) {
-        return node->bid;
+    for (unsigned int i = 0; i < count; i++) {
+        table.Insert(bids[i]);
+    }
+    for (unsigned int i = 0; i < count; i += 2) {
+        Bid bid = bids[i];
+        bid.amount += 1;
+        table.Insert(bid);
+    }
+    for (unsigned int i = 0; i < count; i += 3) {
+        table.Remove(bids[i].bidId);
     }
 
-    // Return bid if node is not found
-    if (node == nullptr || node->key == UINT_MAX) {
-        return bid;
+    loading = false;
+    for (thread& t : threads) {
+        t.join();
     }
 
-    // Loop through chained nodes for match and return bid if found
-    while (node != nullptr) {
-        if (node->key != UINT_MAX && node->bid.bidId.compare(bidId) == 0) {
-            return node->bid;
+    // every bid not removed must be there with its final amount
+    for (unsigned int i = 0; i < count; i++) {
+        Bid bid = table.Search(bids[i].bidId);
+        bool removed = i % 3 == 0;
+        double amount = bids[i].amount + (i % 2 == 0 ? 1 : 0);
+        if (bid.bidId.empty() != removed || (!removed && bid.amount != amount)) {
+            errors++;
         }
-
-        // Set node to next node
-        node = node->next;
+    }
+    if (table.Size() != count - (count + 2) / 3) {
+        errors++;
     }
 
-    return bid;
+    cout << readers << " readers, " << hits << " hits during the load, " << errors << " errors" << endl;
+    return errors == 0;
 }
 
-//============================================================================
-// Static methods used for testing
-//============================================================================
-
 /**
- * Display the bid information to the console (std::out)
+ * Measure ConcurrentHashTable lookup throughput with more and
+ * more reader threads while a loader thread keeps inserting and
+ * removing bids
  *
- * @param bid struct containing the bid info
+ * @param count number of bids
  */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-        << bid.fund << endl;
-    return;
+void benchmarkConcurrent(unsigned int count) {
+    const unsigned int THREADS[] = { 1, 2, 4, 8 };
+    vector<Bid> bids = makeBids(count);
+
+    cout << thread::hardware_concurrency() << " hardware threads" << endl;
+
+    if (!stressConcurrent(4, count)) {
+        cout << "Stress test FAILED" << endl;
+        return;
+    }
+    cout << "Stress test passed" << endl;
+
+    for (unsigned int readers : THREADS) {
+        ConcurrentHashTable table(count);
+        atomic<bool> running(true);
+        atomic<unsigned long long> lookups(0);
+
+        // the first half stays put, the loader churns the second half
+        for (unsigned int i = 0; i < count; i++) {
+            table.Insert(bids[i]);
+        }
+
+        thread loader([&]() {
+            for (unsigned int i = count / 2; running.load(); i = i + 1 < count ? i + 1 : count / 2) {
+                table.Remove(bids[i].bidId);
+                table.Insert(bids[i]);
+            }
+        });
+
+        vector<thread> threads;
+        for (unsigned int r = 0; r < readers; r++) {
+            threads.push_back(thread([&, r]() {
+                unsigned long long local = 0;
+                for (unsigned int i = r; running.load(memory_order_relaxed); i = (i + 7919) % count) {
+                    table.Search(bids[i].bidId);
+                    local++;
+                }
+                lookups += local;
+            }));
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        this_thread::sleep_for(chrono::milliseconds(500));
+        running = false;
+        for (thread& t : threads) {
+            t.join();
+        }
+        loader.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "  " << readers << " readers: " << lookups / seconds << " lookups/s" << endl;
+    }
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Compare looking bids up one Search at a time with SearchBatch
+ * on a table too big for the cache
  *
- * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
+ * @param count number of bids in the table
+ * @param batch number of bid ids in each batch
  */
-void loadBids(string csvPath, HashTable* hashTable) {
-    cout << "Loading CSV file " << csvPath << endl;
-
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+void benchmarkBatch(unsigned int count, unsigned int batch) {
+    const unsigned int ROUNDS = 100;
+    vector<Bid> bids = makeBids(count);
+    BidTable table(count);
+    for (const Bid& bid : bids) {
+        table.Insert(bid.bidId, bid);
+    }
 
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+    // a batch of scattered ids, a quarter of them misses
+    vector<string> bidIds(batch);
+    for (unsigned int i = 0; i < batch; i++) {
+        bidIds[i] = i % 4 == 0 ? to_string(i) : bids[i * 7919ULL % count].bidId;
     }
-    cout << "" << endl;
 
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+    unsigned long long found = 0;
+    clock_t ticks = clock();
+    for (unsigned int r = 0; r < ROUNDS; r++) {
+        for (const string& bidId : bidIds) {
+            found += table.Search(bidId) != nullptr;
+        }
+    }
+    displayTime("Search          ", clock() - ticks, ROUNDS * batch);
 
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+    vector<Bid*> results(batch);
+    ticks = clock();
+    for (unsigned int r = 0; r < ROUNDS; r++) {
+        for (unsigned int i = 0; i < batch; i++) {
+            table.SearchBatch(&bidIds[i], 1, &results[i]);
+        }
+    }
+    displayTime("SearchBatch of 1", clock() - ticks, ROUNDS * batch);
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+    ticks = clock();
+    for (unsigned int r = 0; r < ROUNDS; r++) {
+        table.SearchBatch(bidIds.data(), batch, results.data());
+    }
+    displayTime("SearchBatch     ", clock() - ticks, ROUNDS * batch);
 
-            // push this bid to the end
-            hashTable->Insert(bid);
-        }
+    for (Bid* bid : results) {
+        found -= (bid != nullptr) * ROUNDS;
     }
-    catch (csv::Error& e) {
-        std::cerr << e.what() << std::endl;
+    if (found != 0) {
+        cout << "  Search and SearchBatch found different bids" << endl;
     }
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Build a static index over the bids in a table, save it, map
+ * it back, and compare its memory and lookup time with the table's
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param hashTable the loaded bids
+ * @param indexPath the file to save the index to
+ */
+void benchmarkStaticIndex(BidTable* hashTable, string indexPath) {
+    vector<Bid> bids;
+    hashTable->ForEach([&](const string&, const Bid& bid) {
+        bids.push_back(bid);
+    });
+    if (bids.empty()) {
+        cout << "Load bids first" << endl;
+        return;
+    }
+
+    clock_t ticks = clock();
+    StaticBidIndex built(bids);
+    ticks = clock() - ticks;
+    cout << "Built an index of " << built.Size() << " bids in " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+    built.Save(indexPath);
+    StaticBidIndex mapped(indexPath);
+
+    // look every bid up in a scattered order
+    vector<string> bidIds;
+    for (unsigned int i = 0; i < bids.size(); i++) {
+        bidIds.push_back(bids[i * 7919ULL % bids.size()].bidId);
+    }
+
+    unsigned int found[3] = { 0, 0, 0 };
+    ticks = clock();
+    for (const string& bidId : bidIds) {
+        found[0] += hashTable->Search(bidId) != nullptr;
+    }
+
+    // count the heap buffers of the keys and bids with the table
+    size_t bytes = hashTable->MemoryUsage();
+    hashTable->ForEach([&](const string& bidId, const Bid& bid) {
+        bytes += stringHeapBytes(bidId) + stringHeapBytes(bid.bidId) + stringHeapBytes(bid.title);
+    });
+    cout << "HashTable: " << bytes << " bytes" << endl;
+    displayTime("search", clock() - ticks, bidIds.size());
+
+    ticks = clock();
+    for (const string& bidId : bidIds) {
+        found[1] += !built.Search(bidId).bidId.empty();
+    }
+    cout << "StaticBidIndex: " << built.MemoryUsage() << " bytes" << endl;
+    displayTime("search", clock() - ticks, bidIds.size());
+
+    ticks = clock();
+    for (const string& bidId : bidIds) {
+        found[2] += !mapped.Search(bidId).bidId.empty();
+    }
+    cout << "StaticBidIndex mapped from " << indexPath << ": " << mapped.MemoryUsage() << " bytes" << endl;
+    displayTime("search", clock() - ticks, bidIds.size());
+
+    if (found[1] != found[0] || found[2] != found[0]) {
+        cout << "found " << found[0] << ", " << found[1] << " and " << found[2] << " bids" << endl;
+    }
+}
+
+/**
+ * Save a table's image, map it back, and compare opening and
+ * searching it with loading and searching the table
  *
- * @param ch The character to strip out
+ * @param hashTable the loaded bids
+ * @param csvPath the CSV file the bids were loaded from
+ * @param imagePath the file to save the image to
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+void benchmarkTableImage(BidTable* hashTable, string csvPath, string imagePath) {
+    if (hashTable->Size() == 0) {
+        cout << "Load bids first" << endl;
+        return;
+    }
+
+    clock_t ticks = clock();
+    MappedBidTable::Save(*hashTable, imagePath);
+    ticks = clock() - ticks;
+    cout << "  save image: " << hashTable->Size() << " bids, " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+    ticks = clock();
+    BidTable loaded;
+    loadBids(csvPath, &loaded);
+    ticks = clock() - ticks;
+    cout << "  load table: " << loaded.Size() << " bids, " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+    ticks = clock();
+    MappedBidTable mapped(imagePath);
+    ticks = clock() - ticks;
+    cout << "  map image: " << mapped.Size() << " bids, " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+    // every bid must come back from the image as it went in
+    unsigned int mismatched = 0;
+    vector<string> bidIds;
+    hashTable->ForEach([&](const string& bidId, const Bid& bid) {
+        Bid found = mapped.Search(bidId);
+        if (found.bidId != bid.bidId || found.title != bid.title || found.fundId != bid.fundId
+            || found.amount != bid.amount) {
+            mismatched++;
+        }
+        bidIds.push_back(bidId);
+    });
+    if (mismatched > 0) {
+        cout << mismatched << " bids differ in the image" << endl;
+    }
+
+    // look every bid up in a scattered order
+    vector<string> order;
+    for (unsigned int i = 0; i < bidIds.size(); i++) {
+        order.push_back(bidIds[i * 7919ULL % bidIds.size()]);
+    }
+
+    unsigned int found[2] = { 0, 0 };
+    size_t bytes = hashTable->MemoryUsage();
+    hashTable->ForEach([&](const string& bidId, const Bid& bid) {
+        bytes += stringHeapBytes(bidId) + stringHeapBytes(bid.bidId) + stringHeapBytes(bid.title);
+    });
+    cout << "HashTable: " << bytes << " bytes in each process" << endl;
+    ticks = clock();
+    for (const string& bidId : order) {
+        found[0] += hashTable->Search(bidId) != nullptr;
+    }
+    displayTime("search", clock() - ticks, order.size());
+
+    cout << "MappedBidTable from " << imagePath << ": " << mapped.MemoryUsage() << " bytes shared" << endl;
+    ticks = clock();
+    for (const string& bidId : order) {
+        found[1] += !mapped.Search(bidId).bidId.empty();
+    }
+    displayTime("search", clock() - ticks, order.size());
+
+    if (found[1] != found[0]) {
+        cout << "found " << found[0] << " and " << found[1] << " bids" << endl;
+    }
 }
 
 /**
@@ -346,9 +1935,9 @@ int main(int argc, char* argv[]) {
     clock_t ticks;
 
     // Define a hash table to hold all the bids
-    HashTable* bidTable;
+    BidTable* bidTable;
 
-    Bid bid;
+    Bid* bid;
 
     int choice = 0;
     while (choice != 9) {
@@ -357,6 +1946,14 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Benchmark Tables" << endl;
+        cout << "  6. Benchmark Hash Policies" << endl;
+        cout << "  7. Benchmark Growth" << endl;
+        cout << "  8. Benchmark Concurrent Table" << endl;
+        cout << " 10. Benchmark Batch Search" << endl;
+        cout << " 11. Benchmark Static Index" << endl;
+        cout << " 12. Display Table Statistics" << endl;
+        cout << " 13. Benchmark Table Image" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -364,7 +1961,7 @@ int main(int argc, char* argv[]) {
         switch (choice) {
 
         case 1:
-            bidTable = new HashTable();
+            bidTable = new BidTable();
 
             // Initialize a timer variable before loading bids
             ticks = clock();
@@ -389,8 +1986,8 @@ int main(int argc, char* argv[]) {
 
             ticks = clock() - ticks; // current clock ticks minus starting clock ticks
 
-            if (!bid.bidId.empty()) {
-                displayBid(bid);
+            if (bid != nullptr) {
+                displayBid(*bid);
             }
             else {
                 cout << "Bid Id " << bidKey << " not found." << endl;
@@ -403,6 +2000,48 @@ int main(int argc, char* argv[]) {
         case 4:
             bidTable->Remove(bidKey);
             break;
+
+        case 5:
+            benchmarkTables(1 << 18);
+            break;
+
+        case 6:
+            benchmarkPolicies(20000);
+            break;
+
+        case 7:
+            benchmarkGrowth(200000);
+            break;
+
+        case 8:
+            benchmarkConcurrent(100000);
+            break;
+
+        case 10:
+            benchmarkBatch(1000000, 4096);
+            break;
+
+        case 11:
+            try {
+                benchmarkStaticIndex(bidTable, csvPath + ".idx");
+            }
+            catch (csv::Error& e) {
+                cout << e.what() << endl;
+            }
+            break;
+
+        case 12:
+            displayStats(bidTable->Stats());
+            break;
+
+        case 13:
+            try {
+                benchmarkTableImage(bidTable, csvPath, csvPath + ".img");
+            }
+            catch (runtime_error& e) {
+                cout << e.what() << endl;
+            }
+            break;
         }
     }
 
@@ -0,0 +1,1077 @@
+//============================================================================
+// Name        : HashTable.hpp
+// Author      : Paul Kenaga
+// Version     : 1.0
+// Copyright   : Copyright © 2017 SNHU COCE
+// Description : Chained hash table template and hash policies
+//============================================================================
+
+#ifndef HASHTABLE_HPP
+#define HASHTABLE_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+// Build with -DHASHTABLE_STATS=0 to compile out the probe counters
+// HashTable keeps for its searches
+#ifndef HASHTABLE_STATS
+# define HASHTABLE_STATS 1
+#endif
+
+/**
+ * Bytes a string holds outside itself; short strings are
+ * stored inside the string object and hold none
+ */
+inline std::size_t stringHeapBytes(const std::string& s) {
+    const char* data = s.data();
+    const char* object = reinterpret_cast<const char*>(&s);
+    if (data >= object && data < object + sizeof(s)) {
+        return 0;
+    }
+    return s.capacity() + 1;
+}
+
+/**
+ * Ask for the cache line holding p ahead of its use
+ */
+inline void prefetch(const void* p) {
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#endif
+}
+
+
+//============================================================================
+// Hash policies
+//============================================================================
+
+/**
+ * Multiply two 64 bit values, leaving the low half of the
+ * 128 bit product in a and the high half in b
+ */
+inline void multiply128(std::uint64_t& a, std::uint64_t& b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128) a * b;
+    a = (std::uint64_t) product;
+    b = (std::uint64_t) (product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+#else
+    std::uint64_t ha = a >> 32, la = (std::uint32_t) a, hb = b >> 32, lb = (std::uint32_t) b;
+    std::uint64_t high = ha * hb, middle0 = ha * lb, middle1 = la * hb, low = la * lb;
+    std::uint64_t t = low + (middle0 << 32);
+    std::uint64_t carry = t < low;
+    a = t + (middle1 << 32);
+    carry += a < t;
+    b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+}
+
+/**
+ * Fold the 128 bit product of two values to 64 bits
+ */
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+    multiply128(a, b);
+    return a ^ b;
+}
+
+inline std::uint64_t read64(const char* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t read32(const char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * A wyhash style string hash. Keys of up to 16 bytes, which
+ * covers every bid id, take two overlapping reads and two
+ * 64x64 multiplies; longer keys are consumed 16 bytes a round.
+ * Anything convertible to std::string_view can be hashed.
+ */
+struct StringHash {
+    typedef void is_transparent;
+
+    std::uint64_t operator()(std::string_view key) const {
+        return (*this)(key.data(), key.size());
+    }
+
+    std::uint64_t operator()(const char* p, std::size_t length) const {
+        const std::uint64_t SECRET0 = 0xa0761d6478bd642fULL;
+        const std::uint64_t SECRET1 = 0xe7037ed1a0b428dbULL;
+        const std::uint64_t SECRET2 = 0x8ebc6af09c88c6e3ULL;
+        std::uint64_t seed = mix(SECRET0 ^ length, SECRET1);
+        std::uint64_t a, b;
+
+        if (length <= 16) {
+            if (length >= 4) {
+                std::size_t shift = (length >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + shift);
+                b = (read32(p + length - 4) << 32) | read32(p + length - 4 - shift);
+            }
+            else if (length > 0) {
+                a = ((std::uint64_t) (unsigned char) p[0] << 16) | ((std::uint64_t) (unsigned char) p[length >> 1] << 8)
+                    | (unsigned char) p[length - 1];
+                b = 0;
+            }
+            else {
+                a = b = 0;
+            }
+        }
+        else {
+            std::size_t left = length;
+            while (left > 16) {
+                seed = mix(read64(p) ^ SECRET1, read64(p + 8) ^ seed);
+                p += 16;
+                left -= 16;
+            }
+            a = read64(p + left - 16);
+            b = read64(p + left - 8);
+        }
+
+        a ^= SECRET1;
+        b ^= seed;
+        multiply128(a, b);
+        return mix(a ^ SECRET0 ^ length, b ^ SECRET2);
+    }
+};
+
+/**
+ * Hash for integer keys and numeric ids: integers, and the
+ * digits of a numeric string read as one, are run through the
+ * splitmix64 finalizer, which is cheaper than hashing the text.
+ * Strings that aren't plain numbers fall back to StringHash.
+ */
+struct IntegerHash {
+    typedef void is_transparent;
+
+    std::uint64_t operator()(std::string_view key) const {
+        std::uint64_t value;
+        const char* end = key.data() + key.size();
+        std::from_chars_result result = std::from_chars(key.data(), end, value);
+        if (key.empty() || result.ec != std::errc() || result.ptr != end) {
+            return StringHash()(key);
+        }
+        return (*this)(value);
+    }
+
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    std::uint64_t operator()(T key) const {
+        std::uint64_t value = static_cast<std::uint64_t>(key);
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        value ^= value >> 31;
+        return value;
+    }
+};
+
+// IntegerHash for integer keys, StringHash for everything else
+template <typename K>
+using DefaultHash = typename std::conditional<std::is_integral<K>::value, IntegerHash, StringHash>::type;
+
+// define structures to lay out a HashTable image: the header, one
+// offset per bucket (0 for an empty one), then the entries, each
+// followed by its key and value bytes and padded to 8 bytes, then any
+// extra bytes the writer keeps beside the table. Every position is an
+// offset from the start of the image, so it can be mapped at any
+// address.
+struct HashImageHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t bucketCount; // a power of two
+    std::uint64_t count;
+    std::uint64_t hashCheck; // the writer's hash of HASH_CHECK, so a reader can't use another policy
+    std::uint64_t size;      // bytes in the whole image
+    std::uint64_t extra;     // offset of the extra bytes
+    std::uint64_t extraLength;
+};
+
+struct HashImageEntry {
+    std::uint64_t hash; // full hash of the key
+    std::uint64_t next; // offset of the next entry in the bucket, or 0
+    std::uint32_t keyLength;
+    std::uint32_t valueLength;
+};
+
+constexpr char HASH_IMAGE_MAGIC[8] = { 'H', 'A', 'S', 'H', 'I', 'M', 'G', '\0' };
+constexpr std::uint32_t HASH_IMAGE_VERSION = 2;
+// digits, so IntegerHash and StringHash hash it differently
+constexpr std::string_view HASH_CHECK = "1234567890";
+
+/**
+ * The bytes an image stores for a key: the characters of a
+ * string, or the object representation of an integer
+ */
+inline std::string_view imageBytes(std::string_view key) {
+    return key;
+}
+
+template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+std::string_view imageBytes(const T& key) {
+    return std::string_view(reinterpret_cast<const char*>(&key), sizeof(T));
+}
+
+
+//============================================================================
+// Hash Table class definition
+//============================================================================
+
+// define a structure to hold a snapshot of a HashTable's shape and use
+struct HashTableStats {
+    unsigned int buckets;
+    unsigned int entries;
+    double loadFactor;
+    unsigned int emptyBuckets;
+    // chain lengths of the non-empty buckets
+    unsigned int longestChain;
+    unsigned int medianChain;
+    unsigned int p90Chain;
+    unsigned int p99Chain;
+    // searches since the last ResetStats, and the nodes they compared
+    unsigned long long hits;
+    unsigned long long hitProbes;
+    unsigned long long misses;
+    unsigned long long missProbes;
+};
+
+/**
+ * Define a class template containing data members and methods
+ * to implement a hash table with chaining.
+ *
+ * The Hash policy maps a key to 64 bits; the table size is
+ * always a power of two, so the bucket is the low bits of that.
+ * When both Hash and KeyEqual are transparent (they declare
+ * is_transparent), keys can be looked up as any type they
+ * accept, a std::string_view for a std::string key, without
+ * building a K. Values are only ever moved, so V can be
+ * move-only. Nodes and bucket arrays come from Alloc, rebound.
+ *
+ * The table grows by doubling past its maximum load factor. The
+ * rehash is incremental: each operation moves a few old buckets,
+ * so no single one pays for the whole table.
+ */
+template <typename K, typename V, typename Hash = DefaultHash<K>, typename KeyEqual = std::equal_to<>,
+    typename Alloc = std::allocator<std::pair<const K, V> > >
+class HashTable {
+
+public:
+    typedef std::pair<const K, V> value_type;
+
+    static constexpr unsigned int DEFAULT_SIZE = 179;
+
+    // entries per bucket past which the table doubles its size
+    static constexpr double DEFAULT_LOAD_FACTOR = 1.0;
+
+    // old buckets moved on each operation while the table grows
+    static constexpr unsigned int MIGRATE_BUCKETS = 4;
+
+    // keys SearchBatch has in flight at once
+    static constexpr unsigned int BATCH_WINDOW = 32;
+
+private:
+    // Define structures to hold entries; key and next come first so
+    // they share a cache line with the start of the entry's key
+    struct Node {
+        std::uint64_t key; // full hash of value.first
+        Node* next;
+        value_type value;
+
+        Node(std::uint64_t aKey, K&& aFirst, V&& aSecond)
+            : key(aKey), next(nullptr), value(std::move(aFirst), std::move(aSecond)) {
+        }
+    };
+
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node*> BucketAlloc;
+    typedef std::allocator_traits<NodeAlloc> NodeTraits;
+
+    // Key types Search, SearchBatch and Remove take as they are;
+    // any other is converted to K first
+    template <typename Key, typename H = Hash, typename E = KeyEqual, typename = void>
+    struct Transparent : std::is_same<Key, K> {
+    };
+    template <typename Key, typename H, typename E>
+    struct Transparent<Key, H, E, std::void_t<typename H::is_transparent, typename E::is_transparent> >
+        : std::true_type {
+    };
+
+    // bucket heads of the current table
+    std::vector<Node*, BucketAlloc> nodes;
+
+    // bucket heads of the table being drained into nodes while growing;
+    // empty when no resize is in progress
+    std::vector<Node*, BucketAlloc> oldNodes;
+    unsigned int migrated = 0; // oldNodes below this are drained
+
+    unsigned int tableSize;
+    unsigned int tableMask;
+    unsigned int size = 0;
+    double maxLoadFactor = DEFAULT_LOAD_FACTOR;
+
+    Hash hasher;
+    KeyEqual equal;
+    NodeAlloc allocator;
+
+    // running totals for Stats; see HASHTABLE_STATS
+    unsigned long long hits = 0;
+    unsigned long long hitProbes = 0;
+    unsigned long long misses = 0;
+    unsigned long long missProbes = 0;
+
+    void countSearch(bool hit, unsigned int probes);
+    void grow();
+    void migrate(unsigned int bucket);
+    void step(std::uint64_t key);
+    void destroy(Node* node);
+    template <typename Key>
+    Node* find(const Key& key, std::uint64_t hash);
+
+public:
+    HashTable();
+    explicit HashTable(unsigned int size, const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual(),
+        const Alloc& alloc = Alloc());
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+    virtual ~HashTable();
+
+    V* Insert(K key, V value);
+    template <typename Key>
+    V* Search(const Key& key);
+    template <typename Key>
+    void SearchBatch(const Key* keys, unsigned int count, V** results);
+    template <typename Key>
+    std::vector<V*> SearchBatch(const std::vector<Key>& keys);
+    template <typename Key>
+    bool Remove(const Key& key);
+    template <typename Visitor>
+    void ForEach(Visitor visit);
+    void PrintAll(std::ostream& out = std::cout);
+    template <typename Encode>
+    void SaveImage(const std::string& path, Encode encode, std::string_view extra = std::string_view());
+
+    std::vector<unsigned int> ChainLengths();
+    void SetMaxLoadFactor(double loadFactor);
+    unsigned int Size();
+    std::size_t MemoryUsage();
+    HashTableStats Stats();
+    void ResetStats();
+};
+
+/**
+ * Default constructor
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+HashTable<K, V, Hash, KeyEqual, Alloc>::HashTable() : HashTable(DEFAULT_SIZE) {
+}
+
+/**
+ * Constructor for specifying size of the table
+ * Use to improve efficiency of hashing algorithm
+ * by reducing collisions without wasting memory.
+ * The size is rounded up to a power of two.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+HashTable<K, V, Hash, KeyEqual, Alloc>::HashTable(unsigned int size, const Hash& hash, const KeyEqual& keyEqual,
+    const Alloc& alloc)
+    : nodes(BucketAlloc(alloc)), oldNodes(BucketAlloc(alloc)), hasher(hash), equal(keyEqual), allocator(alloc) {
+    // Set tableSize to the next power of two and resize structure to tableSize
+    tableSize = 1;
+    while (tableSize < size) {
+        tableSize *= 2;
+    }
+    tableMask = tableSize - 1;
+    nodes.resize(tableSize, nullptr);
+}
+
+/**
+ * Destructor
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+HashTable<K, V, Hash, KeyEqual, Alloc>::~HashTable() {
+    // Free every node of both tables
+    for (std::vector<Node*, BucketAlloc>* table : { &nodes, &oldNodes }) {
+        for (Node* node : *table) {
+            while (node != nullptr) {
+                Node* next = node->next;
+                destroy(node);
+                node = next;
+            }
+        }
+    }
+}
+
+/**
+ * Destroy a node and give its memory back to the allocator
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::destroy(Node* node) {
+    NodeTraits::destroy(allocator, node);
+    NodeTraits::deallocate(allocator, node, 1);
+}
+
+/**
+ * Add one search to the running probe totals. Plain adds on
+ * members the search already has in cache; nothing at all
+ * when HASHTABLE_STATS is 0.
+ *
+ * @param hit Whether the key was found
+ * @param probes The number of nodes compared
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+inline void HashTable<K, V, Hash, KeyEqual, Alloc>::countSearch(bool hit, unsigned int probes) {
+#if HASHTABLE_STATS
+    if (hit) {
+        hits++;
+        hitProbes += probes;
+    }
+    else {
+        misses++;
+        missProbes += probes;
+    }
+#else
+    (void) hit;
+    (void) probes;
+#endif
+}
+
+/**
+ * Start doubling the table. The current buckets become the
+ * old table and are drained a few at a time by step().
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::grow() {
+    // a low load factor can fill the table before the last resize
+    // is drained; finish that one first
+    while (migrated < oldNodes.size()) {
+        migrate(migrated++);
+    }
+
+    oldNodes.swap(nodes);
+    migrated = 0;
+    tableSize *= 2;
+    tableMask = tableSize - 1;
+    nodes.assign(tableSize, nullptr);
+}
+
+/**
+ * Move one old bucket's chain into the current table. With
+ * the size doubled, old bucket i splits into buckets i and
+ * i + old size; appending keeps each chain in insertion order.
+ *
+ * @param bucket The old bucket to drain
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::migrate(unsigned int bucket) {
+    Node* node = oldNodes[bucket];
+    if (node == nullptr) {
+        return;
+    }
+    oldNodes[bucket] = nullptr;
+
+    Node** tails[] = { &nodes[bucket], &nodes[bucket + oldNodes.size()] };
+    for (Node** tail : tails) {
+        while (*tail != nullptr) {
+            tail = &(*tail)->next;
+        }
+    }
+
+    while (node != nullptr) {
+        Node* next = node->next;
+        Node**& tail = tails[(node->key & tableMask) != bucket];
+        node->next = nullptr;
+        *tail = node;
+        tail = &node->next;
+        node = next;
+    }
+}
+
+/**
+ * Do a slice of a pending resize before an operation on key:
+ * the key's own old bucket, so only the current table has to be
+ * searched, and the next MIGRATE_BUCKETS buckets in order, so the
+ * old table is drained before the new one fills up.
+ *
+ * @param key The full hash of the key about to be used
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::step(std::uint64_t key) {
+    if (oldNodes.empty()) {
+        return;
+    }
+
+    migrate(key & (oldNodes.size() - 1));
+    for (unsigned int i = 0; i < MIGRATE_BUCKETS && migrated < oldNodes.size(); i++) {
+        migrate(migrated++);
+    }
+
+    // Release the old table once it's drained
+    if (migrated == oldNodes.size()) {
+        std::vector<Node*, BucketAlloc>(oldNodes.get_allocator()).swap(oldNodes);
+    }
+}
+
+/**
+ * Find the first node holding a key, counting the probes
+ *
+ * @param key The key to search for
+ * @param hash The full hash of key
+ * @return The node, or nullptr
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key>
+typename HashTable<K, V, Hash, KeyEqual, Alloc>::Node* HashTable<K, V, Hash, KeyEqual, Alloc>::find(const Key& key,
+    std::uint64_t hash) {
+    step(hash);
+
+    // Loop through chained nodes for match
+    unsigned int probes = 0;
+    for (Node* node = nodes[hash & tableMask]; node != nullptr; node = node->next) {
+        probes++;
+        if (node->key == hash && equal(node->value.first, key)) {
+            countSearch(true, probes);
+            return node;
+        }
+    }
+
+    countSearch(false, probes);
+    return nullptr;
+}
+
+/**
+ * Insert an entry. The key isn't checked against the keys
+ * already present; a repeated key is stored again, after the
+ * first, and Search keeps finding the first.
+ *
+ * @param key The entry's key
+ * @param value The entry's value, moved into the table
+ * @return The stored value; valid until its entry is removed
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+V* HashTable<K, V, Hash, KeyEqual, Alloc>::Insert(K key, V value) {
+    // Assign key to hash
+    std::uint64_t hash = hasher(key);
+
+    // Grow before the new entry would push the table past its load factor
+    if (size + 1 > maxLoadFactor * tableSize) {
+        grow();
+    }
+    step(hash);
+
+    // Loop to find the end of the bucket's chain
+    Node** previousNode = &nodes[hash & tableMask];
+    while (*previousNode != nullptr) {
+        previousNode = &(*previousNode)->next;
+    }
+
+    // Add new newNode to end
+    Node* node = NodeTraits::allocate(allocator, 1);
+    NodeTraits::construct(allocator, node, hash, std::move(key), std::move(value));
+    *previousNode = node;
+    size++;
+    return &node->value.second;
+}
+
+/**
+ * Search for the specified key
+ *
+ * @param key The key to search for
+ * @return The value, or nullptr if key isn't in the table
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key>
+V* HashTable<K, V, Hash, KeyEqual, Alloc>::Search(const Key& key) {
+    if constexpr (Transparent<Key>::value) {
+        Node* node = find(key, hasher(key));
+        return node != nullptr ? &node->value.second : nullptr;
+    }
+    else {
+        return Search(K(key));
+    }
+}
+
+/**
+ * Search for many keys at once. Keys are taken BATCH_WINDOW at
+ * a time: all of them are hashed and their buckets prefetched,
+ * then every bucket head is loaded and its first node
+ * prefetched, then the chains are walked. Each load a key waits
+ * on was started while the other keys were being worked on.
+ *
+ * @param keys The keys to search for
+ * @param count The number of keys
+ * @param results Filled with a pointer to each value found, or
+ *                nullptr; valid until that entry is removed
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::SearchBatch(const Key* keys, unsigned int count, V** results) {
+    if constexpr (!Transparent<Key>::value) {
+        std::vector<K> converted(keys, keys + count);
+        SearchBatch(converted.data(), count, results);
+        return;
+    }
+    else {
+        std::uint64_t hashes[BATCH_WINDOW];
+        Node* heads[BATCH_WINDOW];
+
+        for (unsigned int first = 0; first < count; first += BATCH_WINDOW) {
+            unsigned int window = std::min(count - first, BATCH_WINDOW);
+
+            for (unsigned int i = 0; i < window; i++) {
+                hashes[i] = hasher(keys[first + i]);
+                step(hashes[i]);
+                prefetch(&nodes[hashes[i] & tableMask]);
+            }
+
+            for (unsigned int i = 0; i < window; i++) {
+                heads[i] = nodes[hashes[i] & tableMask];
+                if (heads[i] != nullptr) {
+                    prefetch(heads[i]);
+                }
+            }
+
+            for (unsigned int i = 0; i < window; i++) {
+                unsigned int probes = 0;
+                results[first + i] = nullptr;
+                for (Node* node = heads[i]; node != nullptr; node = node->next) {
+                    probes++;
+                    if (node->key == hashes[i] && equal(node->value.first, keys[first + i])) {
+                        results[first + i] = &node->value.second;
+                        break;
+                    }
+                }
+                countSearch(results[first + i] != nullptr, probes);
+            }
+        }
+    }
+}
+
+/**
+ * Search for many keys at once
+ *
+ * @param keys The keys to search for
+ * @return A pointer to each value found, or nullptr
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key>
+std::vector<V*> HashTable<K, V, Hash, KeyEqual, Alloc>::SearchBatch(const std::vector<Key>& keys) {
+    std::vector<V*> results(keys.size());
+    SearchBatch(keys.data(), keys.size(), results.data());
+    return results;
+}
+
+/**
+ * Remove an entry
+ *
+ * @param key The key to search for
+ * @return Whether an entry was removed
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Key>
+bool HashTable<K, V, Hash, KeyEqual, Alloc>::Remove(const Key& key) {
+    if constexpr (!Transparent<Key>::value) {
+        return Remove(K(key));
+    }
+    else {
+        // Set hash equal to hash of key
+        std::uint64_t hash = hasher(key);
+        step(hash);
+
+        // Unlink and free the first node holding key
+        for (Node** node = &nodes[hash & tableMask]; *node != nullptr; node = &(*node)->next) {
+            if ((*node)->key == hash && equal((*node)->value.first, key)) {
+                Node* removed = *node;
+                *node = removed->next;
+                destroy(removed);
+                size--;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/**
+ * Call visit(key, value) on every entry in the table, in no
+ * particular order
+ *
+ * @param visit The function to call
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Visitor>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::ForEach(Visitor visit) {
+    for (std::vector<Node*, BucketAlloc>* table : { &nodes, &oldNodes }) {
+        for (Node* node : *table) {
+            for (; node != nullptr; node = node->next) {
+                visit(node->value.first, node->value.second);
+            }
+        }
+    }
+}
+
+/**
+ * Print all values, a bucket at a time. Needs an operator<<
+ * for V.
+ *
+ * @param out The stream to print to
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::PrintAll(std::ostream& out) {
+    // Declare local variables
+    Node* node;
+
+    // Finish any resize so every entry is in the current table
+    while (!oldNodes.empty()) {
+        step(0);
+    }
+
+    // Loop through entries from beginning to end
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        node = nodes.at(i);
+
+        // Print first entry in chain
+        if (node != nullptr) {
+            out << "Key " << i << ": " << node->value.second << std::endl;
+
+            // Print entries after first in chain
+            while (node->next != nullptr) {
+                out << "    " << i << ": " << node->next->value.second << std::endl;
+                node = node->next;
+            }
+        }
+    }
+}
+
+/**
+ * Write the table to an image file HashImage can query in place,
+ * through a temporary file so a reader never maps half an image.
+ * Buckets and chains keep their order, and each chain's entries
+ * are stored next to each other. K must be a string or an
+ * integer; encode(value, out) appends a value's bytes to out.
+ *
+ * @param path The file to write
+ * @param encode The function that serializes a V
+ * @param extra Bytes to keep after the entries, such as a table
+ *              the encoded values refer to; HashImage::Extra
+ *              returns them
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+template <typename Encode>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::SaveImage(const std::string& path, Encode encode, std::string_view extra) {
+    // Finish any resize so every entry is in the current table
+    while (!oldNodes.empty()) {
+        step(0);
+    }
+
+    std::string image(sizeof(HashImageHeader) + tableSize * sizeof(std::uint64_t), '\0');
+    std::string value;
+    for (unsigned int i = 0; i < tableSize; i++) {
+        // where the offset of the next entry in this chain goes
+        std::size_t link = sizeof(HashImageHeader) + i * sizeof(std::uint64_t);
+
+        for (Node* node = nodes[i]; node != nullptr; node = node->next) {
+            std::string_view key = imageBytes(node->value.first);
+            value.clear();
+            encode(static_cast<const V&>(node->value.second), value);
+
+            std::uint64_t offset = image.size();
+            std::memcpy(&image[link], &offset, sizeof(offset));
+            link = offset + offsetof(HashImageEntry, next);
+
+            HashImageEntry entry = { node->key, 0, (std::uint32_t) key.size(), (std::uint32_t) value.size() };
+            image.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            image.append(key);
+            image.append(value);
+            image.resize((image.size() + 7) & ~std::size_t(7), '\0');
+        }
+    }
+
+    HashImageHeader header = {};
+    std::memcpy(header.magic, HASH_IMAGE_MAGIC, sizeof(HASH_IMAGE_MAGIC));
+    header.version = HASH_IMAGE_VERSION;
+    header.bucketCount = tableSize;
+    header.count = size;
+    header.hashCheck = hasher(HASH_CHECK);
+    header.extra = image.size();
+    header.extraLength = extra.size();
+    image.append(extra);
+    header.size = image.size();
+    std::memcpy(&image[0], &header, sizeof(header));
+
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(image.data(), image.size());
+        if (!out.flush()) {
+            throw std::runtime_error("HashTable: failed to write " + temp);
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        throw std::runtime_error("HashTable: failed to write " + path);
+    }
+}
+
+/**
+ * Count the entries in each bucket. While a resize is in
+ * progress the old table's buckets follow the current ones.
+ *
+ * @return The chain length of every bucket, in bucket order
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+std::vector<unsigned int> HashTable<K, V, Hash, KeyEqual, Alloc>::ChainLengths() {
+    std::vector<unsigned int> lengths;
+
+    for (std::vector<Node*, BucketAlloc>* table : { &nodes, &oldNodes }) {
+        for (Node* node : *table) {
+            unsigned int length = 0;
+            for (; node != nullptr; node = node->next) {
+                length++;
+            }
+            lengths.push_back(length);
+        }
+    }
+    return lengths;
+}
+
+/**
+ * Set the load factor (entries per bucket) past which Insert
+ * doubles the table
+ *
+ * @param loadFactor The new maximum load factor, finite and above 0
+ * @throws std::invalid_argument for any other value, which would have
+ *         Insert double the table on every call, or never
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::SetMaxLoadFactor(double loadFactor) {
+    if (!std::isfinite(loadFactor) || loadFactor <= 0) {
+        throw std::invalid_argument("HashTable: max load factor must be finite and positive");
+    }
+    maxLoadFactor = loadFactor;
+}
+
+/**
+ * Number of entries in the table
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+unsigned int HashTable<K, V, Hash, KeyEqual, Alloc>::Size() {
+    return size;
+}
+
+/**
+ * Approximate bytes held by the table: its bucket arrays and
+ * its nodes. Memory the keys and values own themselves, and
+ * allocator overhead, aren't counted.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+std::size_t HashTable<K, V, Hash, KeyEqual, Alloc>::MemoryUsage() {
+    return (nodes.capacity() + oldNodes.capacity()) * sizeof(Node*) + size * sizeof(Node);
+}
+
+/**
+ * Measure the table's buckets and collect the running search
+ * totals. Walks every chain, so it costs as much as PrintAll
+ * without the printing. Like PrintAll, it finishes any resize
+ * first, so the buckets measured are the tableSize ones the
+ * load factor is taken over.
+ *
+ * @return The statistics
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+HashTableStats HashTable<K, V, Hash, KeyEqual, Alloc>::Stats() {
+    HashTableStats stats = {};
+
+    // Drained old buckets would otherwise count as empty ones
+    while (!oldNodes.empty()) {
+        step(0);
+    }
+    std::vector<unsigned int> lengths = ChainLengths();
+
+    stats.buckets = lengths.size();
+    stats.entries = size;
+    stats.loadFactor = size * 1.0 / tableSize;
+
+    // keep the non-empty buckets, sorted, for the percentiles
+    std::vector<unsigned int>::iterator used = std::remove(lengths.begin(), lengths.end(), 0u);
+    stats.emptyBuckets = lengths.end() - used;
+    lengths.erase(used, lengths.end());
+    std::sort(lengths.begin(), lengths.end());
+    if (!lengths.empty()) {
+        stats.longestChain = lengths.back();
+        stats.medianChain = lengths[lengths.size() / 2];
+        stats.p90Chain = lengths[lengths.size() * 90 / 100];
+        stats.p99Chain = lengths[lengths.size() * 99 / 100];
+    }
+
+    stats.hits = hits;
+    stats.hitProbes = hitProbes;
+    stats.misses = misses;
+    stats.missProbes = missProbes;
+    return stats;
+}
+
+/**
+ * Zero the running search totals
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+void HashTable<K, V, Hash, KeyEqual, Alloc>::ResetStats() {
+    hits = hitProbes = misses = missProbes = 0;
+}
+
+
+//============================================================================
+// Hash Image class definition
+//============================================================================
+
+/**
+ * Define a class template to query an image written by
+ * HashTable::SaveImage where it lies, usually a file mapped
+ * read-only, without copying or building anything. Any number
+ * of processes can map the same file and share its pages.
+ *
+ * Hash must be the policy the table was saved with; the image
+ * records a hash of a fixed string and the constructor checks
+ * it. Keys are compared by their bytes, so look them up as the
+ * type they were saved as (a string view for a string).
+ */
+template <typename Hash = StringHash>
+class HashImage {
+
+private:
+    const char* data;
+    std::size_t size;
+    const HashImageHeader* header;
+    const std::uint64_t* buckets;
+    Hash hasher;
+
+    const HashImageEntry* entry(std::uint64_t offset) const;
+
+public:
+    HashImage(const char* image, std::size_t bytes, const Hash& hash = Hash());
+
+    template <typename Key>
+    bool Search(const Key& key, std::string_view& value) const;
+    std::string_view Extra() const;
+    unsigned int Size() const;
+    std::size_t MemoryUsage() const;
+};
+
+/**
+ * Check an image and point the bucket array into it
+ *
+ * @param image The image, aligned to 8 bytes
+ * @param bytes The bytes in the image
+ * @param hash The hash the table was saved with
+ */
+template <typename Hash>
+HashImage<Hash>::HashImage(const char* image, std::size_t bytes, const Hash& hash)
+    : data(image), size(bytes), header(reinterpret_cast<const HashImageHeader*>(image)), hasher(hash) {
+    if (size < sizeof(HashImageHeader) || std::memcmp(header->magic, HASH_IMAGE_MAGIC, sizeof(HASH_IMAGE_MAGIC)) != 0
+        || header->version != HASH_IMAGE_VERSION || header->size != size || header->bucketCount == 0
+        || (header->bucketCount & (header->bucketCount - 1)) != 0
+        || sizeof(HashImageHeader) + header->bucketCount * (std::uint64_t) sizeof(std::uint64_t) > header->extra
+        || header->extra > size || header->extraLength != size - header->extra) {
+        throw std::runtime_error("HashImage: not a hash table image");
+    }
+    if (header->hashCheck != hasher(HASH_CHECK)) {
+        throw std::runtime_error("HashImage: image was saved with another hash policy");
+    }
+    buckets = reinterpret_cast<const std::uint64_t*>(data + sizeof(HashImageHeader));
+}
+
+/**
+ * The entry at an offset, or nullptr at the end of a chain or if
+ * the offset or the entry's bytes would run off the image
+ */
+template <typename Hash>
+inline const HashImageEntry* HashImage<Hash>::entry(std::uint64_t offset) const {
+    if (offset == 0 || offset % 8 != 0 || offset > size - sizeof(HashImageEntry)) {
+        return nullptr;
+    }
+    const HashImageEntry* found = reinterpret_cast<const HashImageEntry*>(data + offset);
+    if ((std::uint64_t) found->keyLength + found->valueLength > size - offset - sizeof(HashImageEntry)) {
+        return nullptr;
+    }
+    return found;
+}
+
+/**
+ * Search for the specified key
+ *
+ * @param key The key to search for
+ * @param value Set to the first matching entry's value bytes,
+ *              which live as long as the image
+ * @return Whether key was found
+ */
+template <typename Hash>
+template <typename Key>
+bool HashImage<Hash>::Search(const Key& key, std::string_view& value) const {
+    std::uint64_t hash = hasher(key);
+    std::string_view bytes = imageBytes(key);
+
+    // No chain holds more than every entry, so a damaged image whose
+    // chain loops back still ends
+    std::uint64_t steps = header->count;
+    for (const HashImageEntry* node = entry(buckets[hash & (header->bucketCount - 1)]); node != nullptr && steps > 0;
+        node = entry(node->next), steps--) {
+        const char* stored = reinterpret_cast<const char*>(node + 1);
+        if (node->hash == hash && std::string_view(stored, node->keyLength) == bytes) {
+            value = std::string_view(stored + node->keyLength, node->valueLength);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * The extra bytes saved beside the table, which live as long as
+ * the image
+ */
+template <typename Hash>
+std::string_view HashImage<Hash>::Extra() const {
+    return std::string_view(data + header->extra, header->extraLength);
+}
+
+/**
+ * Number of entries in the image
+ */
+template <typename Hash>
+unsigned int HashImage<Hash>::Size() const {
+    return header->count;
+}
+
+/**
+ * Bytes in the image
+ */
+template <typename Hash>
+std::size_t HashImage<Hash>::MemoryUsage() const {
+    return size;
+}
+
+#endif
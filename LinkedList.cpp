@@ -7,6 +7,7 @@
 //============================================================================
 
 #include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <time.h>
 
@@ -18,16 +19,17 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
+// fund names shared by every bid; a bid only stores its fund's id
+csv::Dictionary funds;
 
 // define a structure to hold bid information
 struct Bid {
     string bidId; // unique identifier
     string title;
-    string fund;
+    csv::Dictionary::Id fundId; // index into funds
     double amount;
     Bid() {
+        fundId = 0;
         amount = 0.0;
     }
 };
@@ -166,7 +168,7 @@ void LinkedList::PrintList() {
         // Output current bidID, title, amount and fund
         cout << currentNode->bid.title << " | "; 
         cout << currentNode->bid.amount << " | ";
-        cout << currentNode->bid.fund << endl;
+        cout << funds.lookup(currentNode->bid.fundId) << endl;
 
         // Set current node equal to next
         currentNode = currentNode->next;
@@ -277,7 +279,7 @@ int LinkedList::Size() {
  */
 void displayBid(Bid bid) {
     cout << bid.bidId << ": " << bid.title << " | " << bid.amount
-         << " | " << bid.fund << endl;
+         << " | " << funds.lookup(bid.fundId) << endl;
     return;
 }
 
@@ -297,62 +299,106 @@ Bid getBid() {
     getline(cin, bid.title);
 
     cout << "Enter fund: ";
-    cin >> bid.fund;
+    string fund;
+    cin >> fund;
+    bid.fundId = funds.intern(fund);
 
     cout << "Enter amount: ";
     cin.ignore();
     string strAmount;
     getline(cin, strAmount);
-    bid.amount = strToDouble(strAmount, '$');
+    csv::parseCurrency(strAmount, bid.amount);
 
     return bid;
 }
 
+/**
+ * Load bids from the binary snapshot written by an earlier CSV load
+ *
+ * @param snapshotPath the path to the snapshot file
+ * @param csvPath the CSV file the snapshot must still match
+ * @return false if there is no usable snapshot
+ */
+bool loadSnapshot(string snapshotPath, string csvPath, LinkedList *list) {
+    // no snapshot yet is the usual first run, not a failure
+    if (!filesystem::exists(snapshotPath)) {
+        return false;
+    }
+
+    try {
+        csv::Snapshot snapshot(snapshotPath, csvPath);
+
+        for (unsigned int i = 0; i < snapshot.rowCount(); i++) {
+            Bid bid;
+            bid.bidId = snapshot.text(i, 0);
+            bid.title = snapshot.text(i, 1);
+            bid.fundId = funds.intern(snapshot.text(i, 2));
+            bid.amount = snapshot.number(i, 0);
+            list->Append(bid);
+        }
+    }
+    catch (csv::Error& e) {
+        cout << e.what() << ", reading CSV instead" << endl;
+        return false;
+    }
+
+    cout << "Loaded snapshot " << snapshotPath << endl;
+    return true;
+}
+
 /**
  * Load a CSV file containing bids into a LinkedList
  *
  * @return a LinkedList containing all the bids read
  */
 void loadBids(string csvPath, LinkedList *list) {
+    // a current snapshot from an earlier load skips text parsing entirely
+    string snapshotPath = csvPath + ".snap";
+    if (loadSnapshot(snapshotPath, csvPath, list)) {
+        return;
+    }
+
     cout << "Loading CSV file " << csvPath << endl;
 
-    // initialize the CSV Parser
-    csv::Parser file = csv::Parser(csvPath);
+    // initialize the CSV Reader, which streams the file one block at a time
+    csv::Reader file(csvPath);
+
+    // bind the CSV columns to Bid fields once, checked against the header here
+    auto binder = csv::makeBinder(file.getHeader(),
+        csv::bind(1, &Bid::bidId, csv::AsString()),
+        csv::bind(0, &Bid::title, csv::AsString()),
+        csv::bind(8, &Bid::fundId, csv::AsInterned(funds)),
+        csv::bind(4, &Bid::amount, csv::AsCurrency()));
+
+    // only the bound columns are parsed, the others are skipped
+    file.project(binder.columns());
+
+    // remember what is read so the next load can map it instead
+    csv::SnapshotWriter snapshot(3, 1);
 
     try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+        // hand each row of the CSV file straight to the container
+        file.forEachRow([&](const csv::Row& row) {
 
-            // initialize a bid using data from current row (i)
+            // fill a bid straight from the field views, no temporary strings
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+            binder.fill(row, bid);
+
+            // record the same fields for the snapshot
+            snapshot.add({ row.view(1), row.view(0), row.view(8) }, { bid.amount });
 
-            //cout << bid.bidId << ": " << bid.title << " | " << bid.fund << " | " << bid.amount << endl;
+            //cout << bid.bidId << ": " << bid.title << " | " << funds.lookup(bid.fundId) << " | " << bid.amount << endl;
 
             // add this bid to the end
             list->Append(bid);
-        }
+        });
+
+        snapshot.write(snapshotPath, csvPath);
     } catch (csv::Error &e) {
         std::cerr << e.what() << std::endl;
     }
 }
 
-/**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
- *
- * credit: http://stackoverflow.com/a/24875936
- *
- * @param ch The character to strip out
- */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
-}
-
 /**
  * The one and only main() method
  *
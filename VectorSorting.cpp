@@ -6,6 +6,7 @@
 // Description : Vector Sorting Algorithms
 //============================================================================
 #include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <time.h>
 
@@ -17,16 +18,17 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
+// fund names shared by every bid; a bid only stores its fund's id
+csv::Dictionary funds;
 
 // define a structure to hold bid information
 struct Bid {
     string bidId; // unique identifier
     string title;
-    string fund;
+    csv::Dictionary::Id fundId; // index into funds
     double amount;
     Bid() {
+        fundId = 0;
         amount = 0.0;
     }
 };
@@ -42,7 +44,7 @@ struct Bid {
  */
 void displayBid(Bid bid) {
     cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-        << bid.fund << endl;
+        << funds.lookup(bid.fundId) << endl;
     return;
 }
 
@@ -62,17 +64,53 @@ Bid getBid() {
     getline(cin, bid.title);
 
     cout << "Enter fund: ";
-    cin >> bid.fund;
+    string fund;
+    cin >> fund;
+    bid.fundId = funds.intern(fund);
 
     cout << "Enter amount: ";
     cin.ignore();
     string strAmount;
     getline(cin, strAmount);
-    bid.amount = strToDouble(strAmount, '$');
+    csv::parseCurrency(strAmount, bid.amount);
 
     return bid;
 }
 
+/**
+ * Load bids from the binary snapshot written by an earlier CSV load
+ *
+ * @param snapshotPath the path to the snapshot file
+ * @param csvPath the CSV file the snapshot must still match
+ * @return false if there is no usable snapshot
+ */
+bool loadSnapshot(string snapshotPath, string csvPath, vector<Bid>& bids) {
+    // no snapshot yet is the usual first run, not a failure
+    if (!filesystem::exists(snapshotPath)) {
+        return false;
+    }
+
+    try {
+        csv::Snapshot snapshot(snapshotPath, csvPath);
+
+        for (unsigned int i = 0; i < snapshot.rowCount(); i++) {
+            Bid bid;
+            bid.bidId = snapshot.text(i, 0);
+            bid.title = snapshot.text(i, 1);
+            bid.fundId = funds.intern(snapshot.text(i, 2));
+            bid.amount = snapshot.number(i, 0);
+            bids.push_back(bid);
+        }
+    }
+    catch (csv::Error& e) {
+        cout << e.what() << ", reading CSV instead" << endl;
+        return false;
+    }
+
+    cout << "Loaded snapshot " << snapshotPath << endl;
+    return true;
+}
+
 /**
  * Load a CSV file containing bids into a container
  *
@@ -85,25 +123,46 @@ vector<Bid> loadBids(string csvPath) {
     // Define a vector data structure to hold a collection of bids.
     vector<Bid> bids;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // a current snapshot from an earlier load skips text parsing entirely
+    string snapshotPath = csvPath + ".snap";
+    if (loadSnapshot(snapshotPath, csvPath, bids)) {
+        return bids;
+    }
+
+    // initialize the CSV Reader, which streams the file one block at a time
+    csv::Reader file(csvPath);
+
+    // bind the CSV columns to Bid fields once, checked against the header here
+    auto binder = csv::makeBinder(file.getHeader(),
+        csv::bind(1, &Bid::bidId, csv::AsString()),
+        csv::bind(0, &Bid::title, csv::AsString()),
+        csv::bind(8, &Bid::fundId, csv::AsInterned(funds)),
+        csv::bind(4, &Bid::amount, csv::AsCurrency()));
+
+    // only the bound columns are parsed, the others are skipped
+    file.project(binder.columns());
+
+    // remember what is read so the next load can map it instead
+    csv::SnapshotWriter snapshot(3, 1);
 
     try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+        // hand each row of the CSV file straight to the container
+        file.forEachRow([&](const csv::Row& row) {
 
-            // Create a data structure and add to the collection of bids
+            // fill a bid straight from the field views, no temporary strings
             Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+            binder.fill(row, bid);
+
+            // record the same fields for the snapshot
+            snapshot.add({ row.view(1), row.view(0), row.view(8) }, { bid.amount });
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+            //cout << "Item: " << bid.title << ", Fund: " << funds.lookup(bid.fundId) << ", Amount: " << bid.amount << endl;
 
             // push this bid to the end
             bids.push_back(bid);
-        }
+        });
+
+        snapshot.write(snapshotPath, csvPath);
     }
     catch (csv::Error& e) {
         std::cerr << e.what() << std::endl;
@@ -233,19 +292,6 @@ void selectionSort(vector<Bid>& bids) {
     }
 }
 
-/**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
- *
- * credit: http://stackoverflow.com/a/24875936
- *
- * @param ch The character to strip out
- */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
-}
-
 /**
  * The one and only main() method
  */